@@ -0,0 +1,78 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "area_resample.h"
+
+#include <algorithm>
+
+AreaDownsampler::AreaDownsampler(int srcW, int srcH, cv::Mat& dst)
+    : dst_(dst), cn_(dst.channels()),
+      norm_((float)dst.cols * dst.rows / ((float)srcW * srcH)) {
+    CV_Assert(dst.depth() == CV_8U && cn_ <= 4 &&
+              dst.cols <= srcW && dst.rows <= srcH);
+    splitAxis(srcW, dst.cols, colSplit_);
+    splitAxis(srcH, dst.rows, rowSplit_);
+    acc_[0].assign(dst.cols * cn_, 0.f);
+    acc_[1].assign(dst.cols * cn_, 0.f);
+}
+
+void AreaDownsampler::splitAxis(int srcN, int dstN, std::vector<Split>& out) {
+    double s = (double)srcN / dstN;
+    out.resize(srcN);
+    for (int i = 0; i < srcN; i++) {
+        int t = std::min((int)(i / s), dstN - 1);
+        double boundary = (t + 1) * s;
+        out[i] = {t, (float)std::min(1.0, boundary - i)};
+    }
+}
+
+void AreaDownsampler::addRow(int y, const uchar* row, int pixelBytes,
+                             const int* channelMap) {
+    const Split& rs = rowSplit_[y];
+    while (cur_ < rs.index) flush();
+    const int cn = cn_;
+    for (int part = 0; part < 2; part++) {
+        float wy = part ? 1.f - rs.weight : rs.weight;
+        if (wy <= 0.f || rs.index + part >= dst_.rows) continue;
+        float* acc = acc_[part].data();
+        for (int x = 0; x < (int)colSplit_.size(); x++) {
+            const Split& cs = colSplit_[x];
+            const uchar* p = row + x * pixelBytes;
+            float w0 = wy * cs.weight;
+            float* a = acc + cs.index * cn;
+            for (int c = 0; c < cn; c++) a[c] += w0 * p[channelMap[c]];
+            if (cs.weight < 1.f && cs.index + 1 < dst_.cols) {
+                float w1 = wy - w0;
+                for (int c = 0; c < cn; c++) a[cn + c] += w1 * p[channelMap[c]];
+            }
+        }
+    }
+}
+
+void AreaDownsampler::finish() {
+    while (cur_ < dst_.rows) flush();
+}
+
+void AreaDownsampler::flush() {
+    uchar* out = dst_.ptr<uchar>(cur_);
+    for (int i = 0; i < dst_.cols * cn_; i++)
+        out[i] = cv::saturate_cast<uchar>(acc_[0][i] * norm_);
+    std::swap(acc_[0], acc_[1]);
+    std::fill(acc_[1].begin(), acc_[1].end(), 0.f);
+    cur_++;
+}
@@ -0,0 +1,60 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// Streams rows of a large image into a smaller one with exact area
+// weights (what INTER_AREA computes for a downscale) while holding only
+// two accumulator rows.  When shrinking, each source pixel overlaps at
+// most two target pixels per axis.
+class AreaDownsampler {
+public:
+    // `dst` (CV_8UC1..4, no larger than srcW x srcH) receives the result.
+    AreaDownsampler(int srcW, int srcH, cv::Mat& dst);
+
+    // Source rows must arrive in order.  `row` holds srcW pixels of
+    // `pixelBytes` bytes each; dst channel c is read from byte
+    // channelMap[c] of every pixel (so RGBA -> BGR is {2, 1, 0}).
+    void addRow(int y, const uchar* row, int pixelBytes,
+                const int* channelMap);
+
+    // Writes every row not completed yet.
+    void finish();
+
+private:
+    // Source pixel i covers [i, i + 1); target pixel t covers
+    // [t * s, (t + 1) * s).  `weight` is the share that lands in
+    // `index`, the rest goes to index + 1.
+    struct Split {
+        int index;
+        float weight;
+    };
+
+    static void splitAxis(int srcN, int dstN, std::vector<Split>& out);
+    void flush();
+
+    cv::Mat& dst_;
+    int cn_;
+    float norm_;
+    std::vector<Split> colSplit_, rowSplit_;
+    std::vector<float> acc_[2];   // target rows cur_ and cur_ + 1
+    int cur_ = 0;
+};
@@ -0,0 +1,239 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "color_planes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+// --- Lab table ----------------------------------------------------
+
+// Nodes every 8 levels per channel, 0..256 (the last one extrapolated
+// so every cell has an upper corner).
+const int LAB_STEP_SHIFT = 3;
+const int LAB_DIM = (256 >> LAB_STEP_SHIFT) + 1;
+const int LAB_FRAC = 1 << LAB_STEP_SHIFT;
+const int LAB_MASK = LAB_FRAC - 1;
+// Table entries carry 6 fraction bits; interpolation adds 3 per axis.
+const int LAB_VALUE_SHIFT = 6;
+const int LAB_SHIFT = LAB_VALUE_SHIFT + 3 * LAB_STEP_SHIFT;
+
+float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f
+                         : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float labF(float t) {
+    return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.f / 116.f;
+}
+
+// 8-bit Lab encoding (L * 255 / 100, a + 128, b + 128) as OpenCV's
+// BGR2Lab computes it, D65 white, in table fixed point.
+struct LabTable {
+    int16_t v[LAB_DIM * LAB_DIM * LAB_DIM][3];
+
+    LabTable() {
+        float lin[LAB_DIM];
+        for (int i = 0; i < LAB_DIM; i++)
+            lin[i] = srgbToLinear((float)(i << LAB_STEP_SHIFT) / 255.f);
+        const float k = (float)(1 << LAB_VALUE_SHIFT);
+        for (int bi = 0; bi < LAB_DIM; bi++)
+            for (int gi = 0; gi < LAB_DIM; gi++)
+                for (int ri = 0; ri < LAB_DIM; ri++) {
+                    float R = lin[ri], G = lin[gi], B = lin[bi];
+                    float X = (0.412453f * R + 0.357580f * G + 0.180423f * B)
+                              / 0.950456f;
+                    float Y = 0.212671f * R + 0.715160f * G + 0.072169f * B;
+                    float Z = (0.019334f * R + 0.119193f * G + 0.950227f * B)
+                              / 1.088754f;
+                    float fy = labF(Y);
+                    float L = Y > 0.008856f ? 116.f * fy - 16.f : 903.3f * Y;
+                    int16_t* out = v[(bi * LAB_DIM + gi) * LAB_DIM + ri];
+                    out[0] = (int16_t)std::lround(L * 255.f / 100.f * k);
+                    out[1] = (int16_t)std::lround(
+                        (500.f * (labF(X) - fy) + 128.f) * k);
+                    out[2] = (int16_t)std::lround(
+                        (200.f * (fy - labF(Z)) + 128.f) * k);
+                }
+    }
+};
+
+const LabTable& labTable() {
+    static const LabTable table;
+    return table;
+}
+
+// Interpolated L, a, b with LAB_SHIFT fraction bits.
+inline void labFixed(const LabTable& t, int B, int G, int R, int out[3]) {
+    int fb = B & LAB_MASK, fg = G & LAB_MASK, fr = R & LAB_MASK;
+    const int16_t (*c)[3] = &t.v[(((B >> LAB_STEP_SHIFT) * LAB_DIM +
+                                   (G >> LAB_STEP_SHIFT)) * LAB_DIM) +
+                                 (R >> LAB_STEP_SHIFT)];
+    const int DG = LAB_DIM, DB = LAB_DIM * LAB_DIM;
+    for (int k = 0; k < 3; k++) {
+        // Along R, then G, then B; each step multiplies by LAB_FRAC
+        int c00 = c[0][k] * LAB_FRAC + (c[1][k] - c[0][k]) * fr;
+        int c01 = c[DG][k] * LAB_FRAC + (c[DG + 1][k] - c[DG][k]) * fr;
+        int c10 = c[DB][k] * LAB_FRAC + (c[DB + 1][k] - c[DB][k]) * fr;
+        int c11 = c[DB + DG][k] * LAB_FRAC +
+                  (c[DB + DG + 1][k] - c[DB + DG][k]) * fr;
+        int c0 = c00 * LAB_FRAC + (c01 - c00) * fg;
+        int c1 = c10 * LAB_FRAC + (c11 - c10) * fg;
+        out[k] = c0 * LAB_FRAC + (c1 - c0) * fb;
+    }
+}
+
+inline uchar labByte(int v) {
+    return cv::saturate_cast<uchar>((v + (1 << (LAB_SHIFT - 1))) >> LAB_SHIFT);
+}
+
+// Fixed-point Lab to CIE units, squared distances in delta E.
+const float LAB_UNIT = 1.f / (1 << LAB_SHIFT);
+const float L_UNIT = LAB_UNIT * 100.f / 255.f;
+
+// --- saturation ---------------------------------------------------
+
+// (255 << 12) / v, rounded: OpenCV's 8-bit HSV divisor table
+struct SatDivisor {
+    int t[256];
+    SatDivisor() {
+        t[0] = 0;
+        for (int v = 1; v < 256; v++) t[v] = cvRound((255 << 12) / (double)v);
+    }
+};
+
+const SatDivisor& satDivisor() {
+    static const SatDivisor d;
+    return d;
+}
+
+// --- pass ---------------------------------------------------------
+
+struct RowOut {
+    uchar *gray, *sat, *L, *a, *b;
+    float* dist;
+};
+
+// One row, with the plane set fixed at compile time so the per-pixel
+// loop carries no branches for planes not asked for.
+template <int P>
+void convertRow(const uchar* p, int n, const RowOut& o, const float bg[3]) {
+    const LabTable& lab = labTable();
+    const int* sdiv = satDivisor().t;
+    for (int x = 0; x < n; x++, p += 3) {
+        int B = p[0], G = p[1], R = p[2];
+        if (P & PLANE_GRAY)
+            o.gray[x] = (uchar)((B * 1868 + G * 9617 + R * 4899 + 8192) >> 14);
+        if (P & PLANE_SAT) {
+            int v = std::max(std::max(B, G), R);
+            int d = v - std::min(std::min(B, G), R);
+            o.sat[x] = (uchar)((d * sdiv[v] + (1 << 11)) >> 12);
+        }
+        if (P & (PLANE_LAB | PLANE_DISTANCE)) {
+            int v[3];
+            labFixed(lab, B, G, R, v);
+            if (P & PLANE_LAB) {
+                o.L[x] = labByte(v[0]);
+                o.a[x] = labByte(v[1]);
+                o.b[x] = labByte(v[2]);
+            }
+            if (P & PLANE_DISTANCE) {
+                float dl = v[0] * L_UNIT - bg[0];
+                float da = v[1] * LAB_UNIT - bg[1];
+                float db = v[2] * LAB_UNIT - bg[2];
+                o.dist[x] = std::sqrt(dl * dl + da * da + db * db);
+            }
+        }
+    }
+}
+
+typedef void (*RowFn)(const uchar*, int, const RowOut&, const float*);
+
+const RowFn ROW_FNS[PLANE_ALL + 1] = {
+    convertRow<0>,  convertRow<1>,  convertRow<2>,  convertRow<3>,
+    convertRow<4>,  convertRow<5>,  convertRow<6>,  convertRow<7>,
+    convertRow<8>,  convertRow<9>,  convertRow<10>, convertRow<11>,
+    convertRow<12>, convertRow<13>, convertRow<14>, convertRow<15>,
+};
+
+// Mean Lab colour of every other border pixel, in CIE units (L 0..100,
+// a and b offset by 128 as in the 8-bit encoding).
+void borderLab(const cv::Mat& bgr, float bg[3]) {
+    const LabTable& lab = labTable();
+    int h = bgr.rows, w = bgr.cols;
+    double sum[3] = {0, 0, 0};
+    int n = 0;
+    auto add = [&](int y, int x) {
+        const uchar* p = bgr.ptr<uchar>(y) + x * 3;
+        int v[3];
+        labFixed(lab, p[0], p[1], p[2], v);
+        for (int k = 0; k < 3; k++) sum[k] += v[k];
+        n++;
+    };
+    for (int x = 0; x < w; x += 2) { add(0, x); add(h - 1, x); }
+    for (int y = 1; y < h - 1; y += 2) { add(y, 0); add(y, w - 1); }
+    bg[0] = (float)(sum[0] / n) * L_UNIT;
+    bg[1] = (float)(sum[1] / n) * LAB_UNIT;
+    bg[2] = (float)(sum[2] / n) * LAB_UNIT;
+}
+
+}  // namespace
+
+void ColorPlanes::compute(const cv::Mat& bgr, int planes) {
+    CV_Assert(bgr.type() == CV_8UC3);
+    planes &= PLANE_ALL & ~present_;
+    if (!planes || bgr.empty()) return;
+
+    cv::Mat dist;
+    RowOut o = {};
+    if (planes & PLANE_GRAY) gray.create(bgr.size(), CV_8UC1);
+    if (planes & PLANE_SAT) sat.create(bgr.size(), CV_8UC1);
+    if (planes & PLANE_LAB) {
+        L.create(bgr.size(), CV_8UC1);
+        a.create(bgr.size(), CV_8UC1);
+        b.create(bgr.size(), CV_8UC1);
+    }
+    float bg[3] = {0, 0, 0};
+    if (planes & PLANE_DISTANCE) {
+        borderLab(bgr, bg);
+        dist.create(bgr.size(), CV_32FC1);
+    }
+
+    RowFn row = ROW_FNS[planes];
+    for (int y = 0; y < bgr.rows; y++) {
+        if (planes & PLANE_GRAY) o.gray = gray.ptr<uchar>(y);
+        if (planes & PLANE_SAT) o.sat = sat.ptr<uchar>(y);
+        if (planes & PLANE_LAB) {
+            o.L = L.ptr<uchar>(y);
+            o.a = a.ptr<uchar>(y);
+            o.b = b.ptr<uchar>(y);
+        }
+        if (planes & PLANE_DISTANCE) o.dist = dist.ptr<float>(y);
+        row(bgr.ptr<uchar>(y), bgr.cols, o, bg);
+    }
+
+    if (planes & PLANE_DISTANCE) {
+        cv::normalize(dist, distance, 0, 255, cv::NORM_MINMAX);
+        distance.convertTo(distance, CV_8UC1);
+    }
+    present_ |= planes;
+}
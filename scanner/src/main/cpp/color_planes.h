@@ -0,0 +1,65 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+// ===================================================================
+// Single-pass colour planes.
+//
+// Strategies read the same frame as gray, HSV saturation, Lab and a
+// distance from the background colour, and each cvtColor() (or our own
+// loop) is another full read of the BGR data.  ColorPlanes produces
+// whichever planes are asked for from one read of each pixel:
+//
+//  - gray and S with the exact integer arithmetic of OpenCV's 8-bit
+//    BGR2GRAY and BGR2HSV, so they are bit-exact;
+//  - L, a*, b* from a 33^3 lookup table over BGR (8 levels per cell)
+//    with fixed-point trilinear interpolation, as OpenCV's 8-bit
+//    BGR2Lab does it; within a level or two of cvtColor;
+//  - CIE76 distance (delta E) from the mean border colour in Lab,
+//    computed before rounding and min-max stretched to 0..255.
+//
+// The table is 210 KB, built once per process.  Planes already present
+// are never recomputed, so a later request converts only what is new.
+// ===================================================================
+
+enum ColorPlane {
+    PLANE_GRAY = 1,
+    PLANE_SAT = 2,        // HSV S
+    PLANE_LAB = 4,        // L, a, b (8-bit Lab encoding)
+    PLANE_DISTANCE = 8,   // delta E from the border colour, stretched
+    PLANE_ALL = 15
+};
+
+class ColorPlanes {
+public:
+    // Computes the `planes` not present yet from `bgr` (CV_8UC3), in
+    // one pass.  One object per frame: every call must pass the same
+    // image.
+    void compute(const cv::Mat& bgr, int planes);
+
+    int present() const { return present_; }
+
+    cv::Mat gray, sat, L, a, b, distance;   // CV_8UC1
+
+private:
+    int present_ = 0;
+};
@@ -0,0 +1,218 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "contour_trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// ===================================================================
+// Suzuki & Abe border following, restricted to outer borders.  The
+// raster scan starts a border at every unset -> set transition unless
+// the last traced pixel to its left on the row belongs to the left side
+// of a border already followed (the start then lies inside that
+// component).  Pixel marks and the direction search order are those of
+// OpenCV's implementation, which is what makes the traces identical.
+// ===================================================================
+
+// Mask values while tracing
+enum : uchar {
+    UNSET = 0,
+    SET = 1,            // set, not on a followed border
+    BORDER = 2,         // on a followed border
+    RIGHT_BORDER = 3,   // on a followed border, unset to its east
+};
+
+// Chain code directions, counter-clockwise from east (y grows down)
+static const cv::Point DIRS[8] = {
+    {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+namespace {
+
+// Vertex list of the border being followed, with twice its signed area
+// and its bounds kept up to date as vertices are appended
+struct Chain {
+    std::vector<cv::Point> pts;
+    int64_t twiceArea;
+    int x0, y0, x1, y1;
+
+    void reset() {
+        pts.clear();
+        twiceArea = 0;
+        x0 = y0 = INT32_MAX;
+        x1 = y1 = INT32_MIN;
+    }
+    void add(cv::Point p) {
+        if (!pts.empty())
+            twiceArea += (int64_t)pts.back().x * p.y - (int64_t)pts.back().y * p.x;
+        pts.push_back(p);
+        x0 = std::min(x0, p.x);
+        x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y);
+        y1 = std::max(y1, p.y);
+    }
+    void close() {
+        twiceArea += (int64_t)pts.back().x * pts[0].y -
+                     (int64_t)pts.back().y * pts[0].x;
+    }
+};
+
+struct Ranked {
+    double area;
+    int slot;     // index into the stored contours, -1 when pruned
+};
+
+// Min-heap on area: the front is the first to go
+bool largerArea(const Ranked& a, const Ranked& b) {
+    return a.area > b.area;
+}
+
+}  // namespace
+
+// Follows the outer border through `start` (a set pixel with unset to
+// its west), marking it and appending the CHAIN_APPROX_SIMPLE vertices:
+// every point where the chain code changes.
+static void followBorder(cv::Mat& mask, cv::Point start, Chain& chain) {
+    const int step = (int)mask.step[0];
+    int deltas[16];
+    for (int i = 0; i < 8; i++)
+        deltas[i] = deltas[i + 8] = DIRS[i].y * step + DIRS[i].x;
+
+    chain.reset();
+    uchar* i0 = mask.ptr<uchar>(start.y) + start.x;
+
+    // Clockwise from the west neighbour for the last set one
+    int s = 4;
+    uchar* i1;
+    do {
+        s = (s - 1) & 7;
+        i1 = i0 + deltas[s];
+    } while (*i1 == UNSET && s != 4);
+    if (s == 4) {
+        *i0 = RIGHT_BORDER;   // isolated pixel
+        chain.add(start);
+        chain.close();
+        return;
+    }
+
+    uchar* i3 = i0;
+    cv::Point pt = start;
+    int prevS = s ^ 4;
+    for (;;) {
+        // Counter-clockwise from the way back for the next set
+        // neighbour; the pixel we came from ends the search at worst
+        int sEnd = s;
+        uchar* i4;
+        do {
+            i4 = i3 + deltas[++s];
+        } while (*i4 == UNSET);
+        s &= 7;
+
+        if ((unsigned)(s - 1) < (unsigned)sEnd)
+            *i3 = RIGHT_BORDER;   // east was looked at and is unset
+        else if (*i3 == SET)
+            *i3 = BORDER;
+
+        if (s != prevS) {
+            chain.add(pt);
+            prevS = s;
+        }
+        pt += DIRS[s];
+
+        if (i4 == i0 && i3 == i1) break;
+        i3 = i4;
+        s = (s + 4) & 7;
+    }
+    chain.close();
+}
+
+std::vector<TracedContour> traceOuterContours(cv::Mat& mask,
+                                              double minBoxArea, int keep) {
+    CV_Assert(mask.type() == CV_8UC1);
+    std::vector<TracedContour> result;
+    int w = mask.cols, h = mask.rows;
+    if (w < 3 || h < 3 || keep <= 0) return result;
+
+    for (int y = 0; y < h; y++) {
+        uchar* row = mask.ptr<uchar>(y);
+        if (y == 0 || y == h - 1) {
+            std::memset(row, UNSET, w);
+            continue;
+        }
+        row[0] = row[w - 1] = UNSET;
+        for (int x = 1; x < w - 1; x++) row[x] = row[x] != 0;
+    }
+
+    Chain chain;
+    std::vector<Ranked> heap;
+    std::vector<TracedContour> stored;
+    std::vector<int> freeSlots;
+    heap.reserve(std::min(keep, 1024) + 1);
+
+    for (int y = 1; y < h - 1; y++) {
+        const uchar* row = mask.ptr<uchar>(y);
+        int prev = UNSET;
+        int leftBorder = 0;   // last marked pixel on this row
+        for (int x = 1; x < w - 1; x++) {
+            int p = row[x];
+            if (p == prev) continue;
+            if (prev != UNSET || p != SET || row[leftBorder] == BORDER) {
+                prev = p;
+                if (p >= BORDER) leftBorder = x;
+                continue;
+            }
+
+            followBorder(mask, cv::Point(x, y), chain);
+            prev = row[x];
+            leftBorder = x;
+
+            double area = std::abs(chain.twiceArea) * 0.5;
+            if ((int)heap.size() == keep && !(area > heap.front().area))
+                continue;
+            Ranked r{area, -1};
+            if ((double)(chain.x1 - chain.x0) * (chain.y1 - chain.y0) >= minBoxArea) {
+                if (freeSlots.empty()) {
+                    r.slot = (int)stored.size();
+                    stored.emplace_back();
+                } else {
+                    r.slot = freeSlots.back();
+                    freeSlots.pop_back();
+                }
+                TracedContour& c = stored[r.slot];
+                c.points.assign(chain.pts.begin(), chain.pts.end());
+                c.area = area;
+                c.bbox = cv::Rect(chain.x0, chain.y0, chain.x1 - chain.x0 + 1,
+                                  chain.y1 - chain.y0 + 1);
+            }
+            heap.push_back(r);
+            std::push_heap(heap.begin(), heap.end(), largerArea);
+            if ((int)heap.size() > keep) {
+                std::pop_heap(heap.begin(), heap.end(), largerArea);
+                if (heap.back().slot >= 0) freeSlots.push_back(heap.back().slot);
+                heap.pop_back();
+            }
+        }
+    }
+
+    std::sort(heap.begin(), heap.end(), largerArea);
+    for (const Ranked& r : heap)
+        if (r.slot >= 0) result.push_back(std::move(stored[r.slot]));
+    return result;
+}
@@ -0,0 +1,52 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// ===================================================================
+// Outer contours of a binary mask, traced exactly as cv::findContours
+// (RETR_EXTERNAL, CHAIN_APPROX_SIMPLE) traces them, but with the area
+// and bounding box accumulated along the way so that only the largest
+// few are ever stored.  Edge maps of busy scenes hold thousands of
+// specks; each is traced once over a reused buffer and forgotten.
+// ===================================================================
+
+struct TracedContour {
+    std::vector<cv::Point> points;   // as findContours returns them
+    double area;                     // as cv::contourArea
+    cv::Rect bbox;                   // as cv::boundingRect
+};
+
+// The `keep` outer contours of largest area, largest first, less those
+// whose points span under `minBoxArea` ((width - 1) x (height - 1), an
+// upper bound on the area of any polygon through them).  Pruned ones
+// still take their place in the ranking, so the result is what sorting
+// every findContours() contour by area, cutting at `keep` and dropping
+// the small ones would give (up to ties in area).
+//
+// `mask` is 8-bit with set pixels non-zero; it is overwritten with trace
+// marks.  The one-pixel frame counts as unset, as in findContours()
+// before OpenCV 3.2; later versions pad the image with zeros and trace
+// frame pixels too.  Masks with a clear frame (collectQuads clears a
+// wider one) trace the same either way.
+std::vector<TracedContour> traceOuterContours(cv::Mat& mask,
+                                              double minBoxArea, int keep);
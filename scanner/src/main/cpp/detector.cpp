@@ -0,0 +1,1139 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "detector.h"
+#include "color_planes.h"
+#include "contour_trace.h"
+#include "flight_recorder.h"
+#include "gradient_field.h"
+#include "mat_pool.h"
+#include "rle_mask.h"
+#include "scanner_log.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+// ===================================================================
+// Document scanner — edge-support scoring pipeline.
+//
+// Key insight: the BEST rectangle is NOT the biggest one.
+// It's the one whose 4 edges have the strongest, most consistent
+// gradient support in the original image.  A real document edge
+// shows a clear brightness/colour change; a false-positive
+// contour from thresholding artifacts does not.
+// ===================================================================
+
+// --- geometry helpers ---------------------------------------------
+
+static double angleCos(const cv::Point& p1, const cv::Point& p2,
+                       const cv::Point& p0) {
+    double dx1 = p1.x - p0.x, dy1 = p1.y - p0.y;
+    double dx2 = p2.x - p0.x, dy2 = p2.y - p0.y;
+    return (dx1 * dx2 + dy1 * dy2)
+         / std::sqrt((dx1*dx1 + dy1*dy1) * (dx2*dx2 + dy2*dy2) + 1e-10);
+}
+
+static void orderPoints(std::vector<cv::Point>& pts) {
+    std::vector<cv::Point> o(4);
+    std::vector<int> s(4), d(4);
+    for (int i = 0; i < 4; i++) {
+        s[i] = pts[i].x + pts[i].y;
+        d[i] = pts[i].y - pts[i].x;
+    }
+    o[0] = pts[std::min_element(s.begin(), s.end()) - s.begin()];
+    o[2] = pts[std::max_element(s.begin(), s.end()) - s.begin()];
+    o[1] = pts[std::min_element(d.begin(), d.end()) - d.begin()];
+    o[3] = pts[std::max_element(d.begin(), d.end()) - d.begin()];
+    pts = o;
+}
+
+// --- parameters --------------------------------------------------
+
+static std::mutex g_paramsMutex;
+static DetectorParams g_params;
+
+// Snapshot for the frame this thread is detecting, taken in
+// prepareFrame(), so a concurrent setDetectorParams() never changes
+// the rules halfway through a frame
+static thread_local DetectorParams t_params;
+
+void setDetectorParams(const DetectorParams& params) {
+    std::lock_guard<std::mutex> lock(g_paramsMutex);
+    g_params = params;
+}
+
+DetectorParams detectorParams() {
+    std::lock_guard<std::mutex> lock(g_paramsMutex);
+    return g_params;
+}
+
+// --- quad validation ---------------------------------------------
+
+struct Candidate {
+    std::vector<cv::Point> quad;
+    double area;
+    double edgeScore;   // average gradient magnitude along boundary
+};
+
+static bool isGoodQuad(const std::vector<cv::Point>& quad, double imgArea,
+                       int imgW, int imgH) {
+    const DetectorParams& p = t_params;
+    double area = cv::contourArea(quad);
+    if (area < imgArea * p.minArea || area > imgArea * p.maxArea) return false;
+    if (!cv::isContourConvex(quad)) return false;
+
+    // Reject quads where 3+ corners sit on the image border
+    int borderMargin = p.borderMargin;
+    int borderCount = 0;
+    for (auto& p : quad) {
+        if (p.x <= borderMargin || p.y <= borderMargin ||
+            p.x >= imgW - borderMargin - 1 || p.y >= imgH - borderMargin - 1)
+            borderCount++;
+    }
+    if (borderCount >= 3) return false;
+
+    double maxCos = 0;
+    for (int j = 2; j < 5; j++) {
+        double cos = std::fabs(angleCos(quad[j % 4], quad[j - 2], quad[j - 1]));
+        if (cos > maxCos) maxCos = cos;
+    }
+    return maxCos < p.maxCornerCos;
+}
+
+// Compute average gradient magnitude along the 4 edges of a quad.
+// Higher = stronger real edges in the image along this quad's boundary.
+static double computeEdgeScore(const std::vector<cv::Point>& quad,
+                               GradientField& grad) {
+    double totalGrad = 0;
+    int numSamples = 0;
+    for (int i = 0; i < 4; i++) {
+        cv::Point p1 = quad[i], p2 = quad[(i + 1) % 4];
+        double edgeLen = cv::norm(p2 - p1);
+        int nSamples = std::max(10, (int)edgeLen);
+        for (int s = 0; s < nSamples; s++) {
+            float t = (float)s / nSamples;
+            int x = (int)(p1.x + t * (p2.x - p1.x));
+            int y = (int)(p1.y + t * (p2.y - p1.y));
+            if (x >= 0 && x < grad.width() && y >= 0 && y < grad.height()) {
+                totalGrad += grad.at(x, y);
+                numSamples++;
+            }
+        }
+    }
+    return numSamples > 0 ? totalGrad / numSamples : 0;
+}
+
+// --- candidate collection ----------------------------------------
+
+// Approximate the largest outer contours to quads and keep the good
+// ones.  Candidates are scored later, once they are in the common
+// working frame.
+static void approxQuads(std::vector<std::vector<cv::Point>>& contours,
+                        double imgArea, int imgW, int imgH,
+                        std::vector<Candidate>& candidates) {
+    // Sort by area descending, check only top candidates
+    std::sort(contours.begin(), contours.end(),
+        [](const auto& a, const auto& b) {
+            return cv::contourArea(a) > cv::contourArea(b);
+        });
+
+    const DetectorParams& p = t_params;
+    int limit = std::min((int)contours.size(), p.contourLimit);
+    for (double eps : p.approxEps) {
+        if (eps <= 0) continue;
+        for (int i = 0; i < limit; i++) {
+            double peri = cv::arcLength(contours[i], true);
+            std::vector<cv::Point> approx;
+            cv::approxPolyDP(contours[i], approx, eps * peri, true);
+            if (approx.size() == 4 &&
+                isGoodQuad(approx, imgArea, imgW, imgH)) {
+                candidates.push_back({approx, cv::contourArea(approx), 0});
+            }
+        }
+    }
+}
+
+static std::atomic<bool> g_streamingContours{false};
+
+void setStreamingContours(bool enabled) {
+    g_streamingContours = enabled;
+}
+
+// External contours of a mask whose border is already cleared; `mask`
+// is consumed.  With streaming contours, only the contours approxQuads()
+// will look at are stored; the specks of a busy edge map are traced and
+// dropped on the spot.
+static std::vector<std::vector<cv::Point>> outerContours(cv::Mat& mask,
+                                                         double imgArea) {
+    std::vector<std::vector<cv::Point>> contours;
+    if (g_streamingContours) {
+        auto traced = traceOuterContours(mask, imgArea * t_params.minArea,
+                                         t_params.contourLimit);
+        contours.reserve(traced.size());
+        for (auto& c : traced) contours.push_back(std::move(c.points));
+    } else {
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL,
+                         cv::CHAIN_APPROX_SIMPLE);
+    }
+    return contours;
+}
+
+// Extract quad candidates from a binary/edge image into the list.
+static void collectQuads(const cv::Mat& edges, double imgArea,
+                         std::vector<Candidate>& candidates) {
+    // Zero out borders to prevent frame-spanning contours
+    cv::Mat clean = edges.clone();
+    int border = t_params.borderMargin;
+    clean.rowRange(0, border).setTo(0);
+    clean.rowRange(clean.rows - border, clean.rows).setTo(0);
+    clean.colRange(0, border).setTo(0);
+    clean.colRange(clean.cols - border, clean.cols).setTo(0);
+
+    auto contours = outerContours(clean, imgArea);
+    approxQuads(contours, imgArea, edges.cols, edges.rows, candidates);
+}
+
+// Same as collectQuads for a run-length mask.  The border is cleared on
+// the runs; the contours are traced on the decoded plane, so they are
+// exactly those of the byte-mask path.
+static void collectQuads(RleMask mask, double imgArea,
+                         std::vector<Candidate>& candidates) {
+    mask.clearBorder(t_params.borderMargin);
+    cv::Mat plane = mask.toMat();
+    auto contours = outerContours(plane, imgArea);
+    approxQuads(contours, imgArea, mask.width(), mask.height(), candidates);
+}
+
+// --- detection strategies ----------------------------------------
+
+static int adaptiveCannyLow(const GradientField& grad);
+
+// Canny low threshold suggested by the frame's gradient statistics.
+// `adaptive` is false when the mode is off; strategies then sweep.
+// The threshold costs one uncached Sobel per 16 pixels, so it is taken
+// on the first Canny level of the frame, not for frames whose gate or
+// route runs no Canny strategy.
+struct CannyHint {
+    bool adaptive = false;
+    const GradientField* grad = nullptr;
+    mutable int lo_ = -1;
+
+    int lo() const {
+        if (lo_ < 0) {
+            lo_ = adaptiveCannyLow(*grad);
+            LOGD("  canny: adaptive lo=%d", lo_);
+        }
+        return lo_;
+    }
+};
+
+// Runs `level(lo)` for the adaptive threshold alone, and for the fixed
+// `sweep` only when adaptive mode is off or its level added nothing.
+// Every level is scaled by DetectorParams::cannyScale.
+template <class LevelFn>
+static void cannyLevels(const CannyHint& hint,
+                        std::initializer_list<int> sweep,
+                        const std::vector<Candidate>& candidates,
+                        LevelFn level) {
+    double scale = t_params.cannyScale;
+    auto scaled = [scale](int lo) {
+        return std::max((int)std::lround(lo * scale), 1);
+    };
+    if (hint.adaptive) {
+        size_t before = candidates.size();
+        level(scaled(hint.lo()));
+        if (candidates.size() > before) return;
+    }
+    for (int lo : sweep) level(scaled(lo));
+}
+
+// Shared 5x5 ellipse for the edge-map dilations, built once
+static const cv::Mat& ellipse5() {
+    static const cv::Mat elem =
+        cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
+    return elem;
+}
+
+// Strategy 1: Per-channel Canny + binary thresholds (squares-demo)
+static void findSquaresMultiChannel(const cv::Mat& img, const ColorPlanes&,
+                                    double imgArea, const CannyHint& hint,
+                                    std::vector<Candidate>& candidates) {
+    cv::Mat pyr, filtered;
+    cv::pyrDown(img, pyr, cv::Size(img.cols / 2, img.rows / 2));
+    cv::pyrUp(pyr, filtered, img.size());
+
+    cv::Mat gray0(filtered.size(), CV_8U);
+    for (int c = 0; c < filtered.channels(); c++) {
+        int ch[] = {c, 0};
+        cv::mixChannels(&filtered, 1, &gray0, 1, ch, 1);
+
+        // Canny pass
+        cannyLevels(hint, {20}, candidates, [&](int lo) {
+            cv::Mat binary;
+            cv::Canny(gray0, binary, lo, lo * 4, 3);
+            cv::dilate(binary, binary, cv::Mat(), cv::Point(-1, -1));
+            collectQuads(binary, imgArea, candidates);
+        });
+
+        // Binary threshold passes, all six levels from one read
+        int levels[6];
+        for (int l = 1; l <= 6; l++) levels[l - 1] = l * 255 / 7;
+        RleMask masks[6];
+        RleMask::thresholdLevels(gray0, levels, 6, masks);
+        for (auto& m : masks)
+            collectQuads(std::move(m), imgArea, candidates);
+    }
+}
+
+// Strategy 2: Morphological gradient (half resolution).  The level-0
+// version used a 7 px median, 3 and 5 px gradients and two 3x3 closes
+// (5 px in all).  Halved and rounded to sizes the kernels accept, that
+// is a 3 px median, 2 and 3 px gradients (DetectorParams defaults) and
+// one 3x3 close.
+static void findByMorphGradient(const cv::Mat&, const ColorPlanes& planes,
+                                double imgArea, const CannyHint&,
+                                std::vector<Candidate>& candidates) {
+    const cv::Mat& gray = planes.gray;
+    cv::Mat blurred;
+    cv::medianBlur(gray, blurred, 3);
+    for (int kSize : t_params.gradientKernels) {
+        if (kSize <= 0) continue;
+        cv::Mat elem = cv::getStructuringElement(cv::MORPH_RECT,
+                                                  cv::Size(kSize, kSize));
+        cv::Mat dilated, eroded, gradient;
+        cv::dilate(blurred, dilated, elem);
+        cv::erode(blurred, eroded, elem);
+        cv::subtract(dilated, eroded, gradient);
+
+        cv::Mat binary;
+        cv::threshold(gradient, binary, 0, 255,
+                      cv::THRESH_BINARY | cv::THRESH_OTSU);
+        collectQuads(RleMask::fromMask(binary).closed(3, 3),
+                     imgArea, candidates);
+    }
+}
+
+// Otsu's threshold from a histogram, as cv::threshold computes it.
+static int otsuThreshold(const int hist[256], int total) {
+    double mu = 0, scale = 1.0 / total;
+    for (int i = 0; i < 256; i++) mu += i * (double)hist[i];
+    mu *= scale;
+
+    double mu1 = 0, q1 = 0, maxSigma = 0;
+    int best = 0;
+    for (int i = 0; i < 256; i++) {
+        double p = hist[i] * scale;
+        mu1 *= q1;
+        q1 += p;
+        double q2 = 1 - q1;
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1 - FLT_EPSILON)
+            continue;
+        mu1 = (mu1 + i * p) / q1;
+        double mu2 = (mu - q1 * mu1) / q2;
+        double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > maxSigma) {
+            maxSigma = sigma;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Strategy 3: HSV saturation (both directions, half resolution)
+static void findBySaturation(const cv::Mat&, const ColorPlanes& planes,
+                             double imgArea, const CannyHint&,
+                             std::vector<Candidate>& candidates) {
+    // One blur into a pooled plane: a level-1 S plane (~120 KB) and
+    // its blur stay in L2 through the histogram and the threshold
+    cv::Mat blurred;
+    cv::GaussianBlur(planes.sat, blurred, cv::Size(5, 5), 0);
+    int hist[256] = {0};
+    for (int y = 0; y < blurred.rows; y++) {
+        const uchar* row = blurred.ptr<uchar>(y);
+        for (int x = 0; x < blurred.cols; x++) hist[row[x]]++;
+    }
+
+    // THRESH_BINARY keeps sat > t; INV is its complement
+    int level = otsuThreshold(hist, (int)blurred.total()) + 1;
+    RleMask above;
+    RleMask::thresholdLevels(blurred, &level, 1, &above);
+
+    for (const RleMask& t : {above.inverted(), above}) {
+        RleMask cleaned = t.closed(5, 5, 3).opened(3, 3);
+        collectQuads(std::move(cleaned), imgArea, candidates);
+    }
+}
+
+// Strategy 4: Perceptual distance from the background colour (half
+// resolution)
+static void findByColorDistance(const cv::Mat&, const ColorPlanes& planes,
+                                double imgArea, const CannyHint&,
+                                std::vector<Candidate>& candidates) {
+    cv::Mat binary;
+    cv::threshold(planes.distance, binary, 0, 255,
+                  cv::THRESH_BINARY | cv::THRESH_OTSU);
+    collectQuads(RleMask::fromMask(binary).closed(5, 5, 3),
+                 imgArea, candidates);
+}
+
+// Strategy 5: Lab L/a*/b* edges
+static void findByLabEdges(const cv::Mat&, const ColorPlanes& planes,
+                           double imgArea, const CannyHint& hint,
+                           std::vector<Candidate>& candidates) {
+    cv::Mat l, a, b;
+    cv::GaussianBlur(planes.L, l, cv::Size(5, 5), 0);
+    cv::GaussianBlur(planes.a, a, cv::Size(5, 5), 0);
+    cv::GaussianBlur(planes.b, b, cv::Size(5, 5), 0);
+    cannyLevels(hint, {10, 25, 45}, candidates, [&](int lo) {
+        cv::Mat eL, eA, eB, combined;
+        cv::Canny(l, eL, lo, lo * 3);
+        cv::Canny(a, eA, lo, lo * 3);
+        cv::Canny(b, eB, lo, lo * 3);
+        cv::bitwise_or(eA, eB, combined);
+        cv::bitwise_or(combined, eL, combined);
+        cv::dilate(combined, combined, ellipse5());
+        collectQuads(combined, imgArea, candidates);
+    });
+}
+
+// Strategy 6: CLAHE-enhanced Canny
+static void findByCLAHECanny(const cv::Mat&, const ColorPlanes& planes,
+                             double imgArea, const CannyHint& hint,
+                             std::vector<Candidate>& candidates) {
+    // CLAHE objects keep internal state, so one per thread
+    static thread_local cv::Ptr<cv::CLAHE> clahe =
+        cv::createCLAHE(3.0, cv::Size(8, 8));
+    clahe->setClipLimit(t_params.claheClip);
+    cv::Mat enhanced;
+    clahe->apply(planes.gray, enhanced);
+
+    // The blur is shared by every level
+    cv::Mat blurred, canny, edges;
+    cv::GaussianBlur(enhanced, blurred, cv::Size(5, 5), 0);
+    cannyLevels(hint, {20, 40, 70}, candidates, [&](int lo) {
+        cv::Canny(blurred, canny, lo, lo * 2.5);
+        cv::dilate(canny, edges, ellipse5());
+        collectQuads(edges, imgArea, candidates);
+    });
+}
+
+// Strategy 7: Corner assembly.  Strong Shi-Tomasi corners with two
+// dominant edge directions are linked when the segment between them
+// runs along a direction of both ends and is backed by gradient; every
+// 4-cycle of that graph is a quad candidate.  No contour has to
+// survive, so a page whose edge fades along one side is still found.
+
+struct CornerFeature {
+    cv::Point pt;
+    float dir[2];   // edge directions in [0, pi)
+};
+
+static float angleDiff(float a, float b) {
+    float d = std::fabs(a - b);
+    return std::min(d, (float)CV_PI - d);
+}
+
+// Two dominant edge directions from a magnitude-weighted 10-degree
+// orientation histogram around `p`.  False for blobs and single edges.
+static bool dominantDirections(const cv::Mat& dx, const cv::Mat& dy,
+                               cv::Point p, int radius, float dir[2]) {
+    const int BINS = 18;
+    float hist[BINS] = {0};
+    int x0 = std::max(p.x - radius, 0), x1 = std::min(p.x + radius, dx.cols - 1);
+    int y0 = std::max(p.y - radius, 0), y1 = std::min(p.y + radius, dx.rows - 1);
+    for (int y = y0; y <= y1; y++) {
+        const short* gx = dx.ptr<short>(y);
+        const short* gy = dy.ptr<short>(y);
+        for (int x = x0; x <= x1; x++) {
+            int m = std::abs(gx[x]) + std::abs(gy[x]);
+            if (m < 32) continue;
+            // Edge runs perpendicular to the gradient
+            float a = std::atan2((float)gy[x], (float)gx[x]) + (float)CV_PI / 2;
+            a = std::fmod(a + 2 * (float)CV_PI, (float)CV_PI);
+            hist[std::min((int)(a * BINS / CV_PI), BINS - 1)] += m;
+        }
+    }
+    float smooth[BINS];
+    for (int b = 0; b < BINS; b++)
+        smooth[b] = hist[(b + BINS - 1) % BINS] + 2 * hist[b] +
+                    hist[(b + 1) % BINS];
+
+    int b1 = (int)(std::max_element(smooth, smooth + BINS) - smooth);
+    int b2 = -1;
+    for (int b = 0; b < BINS; b++) {
+        int d = std::abs(b - b1);
+        if (std::min(d, BINS - d) < 3) continue;   // >= 30 degrees apart
+        if (b2 < 0 || smooth[b] > smooth[b2]) b2 = b;
+    }
+    if (smooth[b1] <= 0 || b2 < 0 || smooth[b2] < 0.35f * smooth[b1])
+        return false;
+    dir[0] = (b1 + 0.5f) * (float)CV_PI / BINS;
+    dir[1] = (b2 + 0.5f) * (float)CV_PI / BINS;
+    return true;
+}
+
+// Mean L1 gradient along the segment a-b
+static double segmentSupport(const cv::Mat& dx, const cv::Mat& dy,
+                             cv::Point a, cv::Point b) {
+    int n = std::max(8, (int)cv::norm(b - a) / 2);
+    double sum = 0;
+    for (int i = 0; i <= n; i++) {
+        int x = a.x + (b.x - a.x) * i / n, y = a.y + (b.y - a.y) * i / n;
+        sum += std::abs(dx.at<short>(y, x)) + std::abs(dy.at<short>(y, x));
+    }
+    return sum / (n + 1);
+}
+
+static void findByCorners(const cv::Mat&, const ColorPlanes& planes,
+                          double imgArea, const CannyHint&,
+                          std::vector<Candidate>& candidates) {
+    const cv::Mat& gray = planes.gray;
+    cv::Mat blurred;
+    cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+
+    std::vector<cv::Point2f> pts;
+    int longSide = std::max(gray.cols, gray.rows);
+    cv::goodFeaturesToTrack(blurred, pts, 60, 0.02, longSide * 0.03,
+                            cv::noArray(), 7);
+    if (pts.size() < 4) return;
+
+    cv::Mat dx, dy;
+    cv::Sobel(blurred, dx, CV_16S, 1, 0);
+    cv::Sobel(blurred, dy, CV_16S, 0, 1);
+
+    std::vector<CornerFeature> corners;
+    int radius = std::max(4, longSide / 100);
+    for (auto& p : pts) {
+        CornerFeature c;
+        c.pt = cv::Point(cvRound(p.x), cvRound(p.y));
+        if (dominantDirections(dx, dy, c.pt, radius, c.dir))
+            corners.push_back(c);
+    }
+    int n = (int)corners.size();
+    if (n < 4) return;
+
+    // Edge support floor: twice the mean gradient of the frame
+    cv::Scalar mx = cv::mean(cv::abs(dx)), my = cv::mean(cv::abs(dy));
+    double minSupport = 2 * (mx[0] + my[0]);
+
+    // Link pairs whose segment follows a dominant direction at both
+    // ends (within 12 degrees) and has gradient along it
+    const float TOL = (float)(12 * CV_PI / 180);
+    double minSide = std::sqrt(imgArea * t_params.minArea) * 0.25;
+    std::vector<std::vector<int>> adj(n);
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            cv::Point d = corners[j].pt - corners[i].pt;
+            if (cv::norm(d) < minSide) continue;
+            float a = std::atan2((float)d.y, (float)d.x);
+            a = std::fmod(a + 2 * (float)CV_PI, (float)CV_PI);
+            auto fits = [&](const CornerFeature& c) {
+                return angleDiff(a, c.dir[0]) < TOL ||
+                       angleDiff(a, c.dir[1]) < TOL;
+            };
+            if (!fits(corners[i]) || !fits(corners[j])) continue;
+            if (segmentSupport(dx, dy, corners[i].pt, corners[j].pt) <
+                minSupport)
+                continue;
+            adj[i].push_back(j);
+            adj[j].push_back(i);
+        }
+    }
+
+    // 4-cycles i-j-k-l with i the smallest index and j < l, so each
+    // cycle is visited once
+    const size_t MAX_QUADS = 64;
+    std::vector<char> isAdjI(n);
+    size_t added = 0;
+    for (int i = 0; i < n && added < MAX_QUADS; i++) {
+        std::fill(isAdjI.begin(), isAdjI.end(), 0);
+        for (int v : adj[i]) isAdjI[v] = 1;
+        for (int j : adj[i]) {
+            if (j < i) continue;
+            for (int k : adj[j]) {
+                if (k <= i || k == j) continue;
+                for (int l : adj[k]) {
+                    if (l <= j || l == k || !isAdjI[l]) continue;
+                    std::vector<cv::Point> quad = {
+                        corners[i].pt, corners[j].pt,
+                        corners[k].pt, corners[l].pt};
+                    if (!isGoodQuad(quad, imgArea, gray.cols, gray.rows))
+                        continue;
+                    candidates.push_back({quad, cv::contourArea(quad), 0});
+                    if (++added >= MAX_QUADS) return;
+                }
+            }
+        }
+    }
+}
+
+// --- strategy table ----------------------------------------------
+
+typedef void (*StrategyFn)(const cv::Mat& bgr, const ColorPlanes& planes,
+                           double imgArea, const CannyHint& hint,
+                           std::vector<Candidate>& candidates);
+
+// `level` picks the pyramid image a strategy runs on: 0 is the
+// working image, each further level halves it.  Edge tracing needs
+// full resolution; the region strategies only look for large blobs
+// and run at level 1, with blur and morphology kernels resized for it
+// (about half their level-0 size, rounded to what the kernel accepts;
+// each strategy lists its own).  `planes` lists the ColorPlanes it
+// reads there.
+struct Strategy {
+    const char* name;
+    int level;
+    int planes;
+    StrategyFn run;
+};
+
+static const Strategy STRATEGIES[] = {
+    {"corners",       0, PLANE_GRAY,     findByCorners},
+    {"multiChannel",  0, 0,              findSquaresMultiChannel},
+    {"morphGradient", 1, PLANE_GRAY,     findByMorphGradient},
+    {"saturation",    1, PLANE_SAT,      findBySaturation},
+    {"colorDist",     1, PLANE_DISTANCE, findByColorDistance},
+    {"labEdges",      0, PLANE_LAB,      findByLabEdges},
+    {"claheCanny",    0, PLANE_GRAY,     findByCLAHECanny},
+};
+
+static const int STRATEGY_COUNT =
+    (int)(sizeof(STRATEGIES) / sizeof(STRATEGIES[0]));
+
+// Maps the candidates a strategy added from its pyramid level back to
+// the working frame and, unless bounded scoring will, scores them there.
+static void mapAndScore(std::vector<Candidate>& candidates, size_t first,
+                        const cv::Size& from, GradientField& grad,
+                        bool score = true) {
+    double sx = (double)grad.width() / from.width;
+    double sy = (double)grad.height() / from.height;
+    bool scaled = from != cv::Size(grad.width(), grad.height());
+    for (size_t i = first; i < candidates.size(); i++) {
+        Candidate& c = candidates[i];
+        if (scaled) {
+            for (auto& p : c.quad) {
+                p.x = (int)std::round((p.x + 0.5) * sx - 0.5);
+                p.y = (int)std::round((p.y + 0.5) * sy - 0.5);
+            }
+            c.area = cv::contourArea(c.quad);
+        }
+        c.edgeScore = score ? computeEdgeScore(c.quad, grad) : 0;
+    }
+}
+
+// --- early rejection ----------------------------------------------
+
+static thread_local RejectReason g_lastReject = REJECT_NONE;
+
+RejectReason lastRejectReason() {
+    return g_lastReject;
+}
+
+// Cheap "is there any plausible document?" check on a ~128 px
+// thumbnail.  A document needs at least two non-parallel straight
+// edges in view (two corners may sit off-frame, never three), so a
+// frame without them cannot produce a valid quad.  Thresholds are
+// deliberately loose: a false reject costs a missed frame, a false
+// accept only costs the time we spend today.
+static RejectReason quickReject(const cv::Mat& gray) {
+    const int THUMB = 128;
+    cv::Mat thumb;
+    double s = (double)THUMB / std::max(gray.rows, gray.cols);
+    if (s < 1.0)
+        cv::resize(gray, thumb, cv::Size(), s, s, cv::INTER_AREA);
+    else
+        thumb = gray;
+
+    // BORDER_REPLICATE matches Canny's internal Sobel, so the same
+    // derivatives feed both the contrast test and the edge map.
+    cv::Mat dx, dy;
+    cv::Sobel(thumb, dx, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Sobel(thumb, dy, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+
+    // 99th percentile of the L1 gradient.  Below 16 (a 4-level step)
+    // even the lowest Canny sweep in the strategies finds nothing.
+    int hist[64] = {0};
+    for (int y = 0; y < thumb.rows; y++) {
+        const short* gx = dx.ptr<short>(y);
+        const short* gy = dy.ptr<short>(y);
+        for (int x = 0; x < thumb.cols; x++) {
+            int m = std::abs(gx[x]) + std::abs(gy[x]);
+            hist[std::min(m, 63)]++;
+        }
+    }
+    int above = (int)(thumb.total() / 100), p99 = 63;
+    for (int acc = 0; p99 > 0; p99--) {
+        acc += hist[p99];
+        if (acc > above) break;
+    }
+    if (p99 < 16) return REJECT_LOW_CONTRAST;
+
+    cv::Mat edges;
+    cv::Canny(dx, dy, edges, 16, 40);
+    std::vector<cv::Vec2f> lines;
+    int votes = std::max(10, (int)(0.15 * std::min(thumb.rows, thumb.cols)));
+    cv::HoughLines(edges, lines, 1, CV_PI / 90, votes);
+
+    // Lines come back strongest first; look for a crossing pair
+    int n = std::min((int)lines.size(), 32);
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            double d = std::fabs(lines[i][1] - lines[j][1]);
+            d = std::min(d, CV_PI - d);
+            if (d > CV_PI / 6) return REJECT_NONE;
+        }
+    }
+    return REJECT_NO_STRAIGHT_EDGES;
+}
+
+// --- main pipeline ------------------------------------------------
+
+static std::atomic<bool> g_adaptiveCanny{true};
+
+void setAdaptiveCanny(bool enabled) {
+    g_adaptiveCanny = enabled;
+}
+
+// Canny low threshold from the 90th percentile of the gradient
+// magnitude (sampled on every fourth row and column).  Document edges
+// sit in the top few percent; the strategies blur before Canny, which
+// roughly halves a step's response, and use high = 2.5..4 x low, so a
+// quarter of p90 puts the high threshold just under the strong edges.
+// Clamped to the span the fixed sweeps cover.
+static int adaptiveCannyLow(const GradientField& grad) {
+    int hist[256] = {0}, n = 0;
+    for (int y = 1; y < grad.height(); y += 4)
+        for (int x = 1; x < grad.width(); x += 4, n++)
+            hist[std::min((int)grad.sample(x, y) >> 2, 255)]++;
+    int above = n / 10, bin = 255;
+    for (int acc = 0; bin > 0; bin--) {
+        acc += hist[bin];
+        if (acc > above) break;
+    }
+    double p90 = bin * 4 + 2;
+    return std::min(std::max((int)std::lround(p90 / 4), 10), 70);
+}
+
+// Per-frame inputs shared by every strategy.
+struct FrameContext {
+    std::vector<cv::Mat> pyramid;   // [0] is the BGR working image
+    ColorPlanes colors[2];          // of pyramid levels 0 and 1
+    int expected[2] = {0, 0};       // planes queued strategies will read
+    cv::Mat gray;
+    GradientField grad;             // scores every candidate, lazily
+    cv::Mat gradBound;              // per-block bound, for bounded scoring
+    double imgArea;
+    CannyHint canny;
+
+    // Pyramid level `l`, built on first use
+    const cv::Mat& level(int l) {
+        while ((int)pyramid.size() <= l) {
+            const cv::Mat& prev = pyramid.back();
+            cv::Mat half;
+            cv::resize(prev, half,
+                       cv::Size((prev.cols + 1) / 2, (prev.rows + 1) / 2),
+                       0, 0, cv::INTER_AREA);
+            pyramid.push_back(half);
+        }
+        return pyramid[l];
+    }
+
+    // Colour planes of level `l` with at least `need`; whatever queued
+    // strategies will read there comes out of the same pass.
+    const ColorPlanes& planes(int l, int need) {
+        CV_Assert(l < 2);
+        colors[l].compute(level(l), need | expected[l]);
+        return colors[l];
+    }
+};
+
+// Queues the planes of the strategies marked in `run`, so each level is
+// converted once for all of them.
+static void expectPlanes(FrameContext& f, const bool run[]) {
+    for (int i = 0; i < STRATEGY_COUNT; i++)
+        if (run[i]) f.expected[STRATEGIES[i].level] |= STRATEGIES[i].planes;
+}
+
+// Gray conversion, optional quickReject() gate, gradient magnitude.
+// Returns false (and records the reason) when the gate drops the frame.
+static bool prepareFrame(const cv::Mat& small, bool earlyReject,
+                         FrameContext& f) {
+    FrameTrace::input(small);
+    g_lastReject = REJECT_NONE;
+    t_params = detectorParams();
+    f.pyramid.assign(1, small);
+    f.imgArea = small.rows * small.cols;
+    f.gray = f.planes(0, PLANE_GRAY).gray;
+
+    if (earlyReject) {
+        RejectReason reason = quickReject(f.gray);
+        if (reason != REJECT_NONE) {
+            LOGD("  RESULT: rejected early, reason=%d", reason);
+            g_lastReject = reason;
+            FrameTrace::mark("reject");
+            return false;
+        }
+    }
+
+    // Gradient magnitude used to score ALL candidates; only the tiles
+    // candidate edges pass through are ever computed
+    f.grad = GradientField(f.gray);
+    f.canny = CannyHint();
+    f.canny.adaptive = g_adaptiveCanny.load();
+    f.canny.grad = &f.grad;
+    FrameTrace::mark("prepare");
+    return true;
+}
+
+// Runs one strategy on its pyramid level and appends its candidates,
+// mapped to the working frame, with their combined score in edgeScore
+// (left at 0 with `score` false, for scoreBounded()).
+//
+// Combined score = edgeScore * areaRatio
+// Linear area weight strongly favours bigger quads while still
+// letting edge quality break ties between similar-sized candidates.
+//  - Tiny text quad (7% area, edge 260):  260 * 0.07 = 18
+//  - Real document  (40% area, edge 60):   60 * 0.40 = 24  ← wins!
+//  - Big false pos  (80% area, edge 30):   30 * 0.80 = 24
+static void runStrategy(const Strategy& st, FrameContext& f,
+                        std::vector<Candidate>& candidates,
+                        bool score = true) {
+    const cv::Mat& img = f.level(st.level);
+    const ColorPlanes& planes = f.planes(st.level, st.planes);
+    size_t first = candidates.size();
+    st.run(img, planes, (double)img.rows * img.cols, f.canny, candidates);
+    mapAndScore(candidates, first, img.size(), f.grad, score);
+    for (size_t i = first; i < candidates.size(); i++)
+        candidates[i].edgeScore *= candidates[i].area / f.imgArea;
+    LOGD("  after %s: %d candidates", st.name, (int)candidates.size());
+    FrameTrace::mark(st.name);
+}
+
+// --- bounded scoring ----------------------------------------------
+
+// Only the winner of detectDocument() needs an exact score, so a
+// candidate can be dropped as soon as it provably cannot beat the best
+// combined score seen so far.  The proof needs an upper bound on the
+// samples not read yet: Sobel 3x3 components are at most 4x the
+// intensity range of the 3x3 neighbourhood, so per block of the gray
+// image (plus a one-pixel halo) the magnitude is at most
+// 4 * sqrt(2) * (max - min).  Flat regions - where false quads in
+// text and texture lie - get tight bounds, so those candidates die
+// after their coarsest pass or before any sample at all.
+//
+// Magnitudes are 0 or >= 1 and below 1443, and an edge has a few
+// thousand samples, so the double sum of the float samples is exact in
+// any order: a candidate that survives gets exactly the exhaustive
+// score, and the final ranking of the winner matches exhaustive
+// scoring.
+
+static std::atomic<bool> g_boundedScoring{true};
+
+void setBoundedScoring(bool enabled) {
+    g_boundedScoring = enabled;
+}
+
+static const int BOUND_BLOCK = 16;
+
+static cv::Mat gradientBound(const cv::Mat& gray) {
+    int bw = (gray.cols + BOUND_BLOCK - 1) / BOUND_BLOCK;
+    int bh = (gray.rows + BOUND_BLOCK - 1) / BOUND_BLOCK;
+    cv::Mat bound(bh, bw, CV_32F);
+    // Slightly above 4 * sqrt(2), to cover float rounding of magnitude()
+    const float K = 5.6570f;
+    for (int by = 0; by < bh; by++) {
+        int y0 = std::max(by * BOUND_BLOCK - 1, 0);
+        int y1 = std::min((by + 1) * BOUND_BLOCK + 1, gray.rows);
+        for (int bx = 0; bx < bw; bx++) {
+            int x0 = std::max(bx * BOUND_BLOCK - 1, 0);
+            int x1 = std::min((bx + 1) * BOUND_BLOCK + 1, gray.cols);
+            int lo = 255, hi = 0;
+            for (int y = y0; y < y1; y++) {
+                const uchar* p = gray.ptr<uchar>(y);
+                for (int x = x0; x < x1; x++) {
+                    lo = std::min(lo, (int)p[x]);
+                    hi = std::max(hi, (int)p[x]);
+                }
+            }
+            bound.at<float>(by, bx) = K * (hi - lo);
+        }
+    }
+    return bound;
+}
+
+// computeEdgeScore() over the same samples, visited coarse to fine
+// (every 8th of each edge, then the 4ths, 2nds and the rest).  Returns
+// -1 once `weight` times the best possible final score is below
+// `floor`.
+static double boundedEdgeScore(const std::vector<cv::Point>& quad,
+                               GradientField& grad, const cv::Mat& bound,
+                               double weight, double floor) {
+    std::vector<cv::Point> pts;
+    int edgeEnd[4];
+    for (int i = 0; i < 4; i++) {
+        cv::Point p1 = quad[i], p2 = quad[(i + 1) % 4];
+        int nSamples = std::max(10, (int)cv::norm(p2 - p1));
+        for (int s = 0; s < nSamples; s++) {
+            float t = (float)s / nSamples;
+            int x = (int)(p1.x + t * (p2.x - p1.x));
+            int y = (int)(p1.y + t * (p2.y - p1.y));
+            if (x >= 0 && x < grad.width() && y >= 0 && y < grad.height())
+                pts.emplace_back(x, y);
+        }
+        edgeEnd[i] = (int)pts.size();
+    }
+    if (pts.empty()) return 0;
+
+    auto boundAt = [&](const cv::Point& p) {
+        return (double)bound.at<float>(p.y / BOUND_BLOCK, p.x / BOUND_BLOCK);
+    };
+    double sum = 0, rest = 0, n = (double)pts.size();
+    for (const auto& p : pts) rest += boundAt(p);
+    // The relative margin absorbs rounding in the running `rest`
+    auto hopeless = [&] {
+        return (sum + rest) * (1 + 1e-9) / n * weight < floor;
+    };
+    if (hopeless()) return -1;
+
+    for (int stride : {8, 4, 2, 1}) {
+        int first = stride == 8 ? 0 : stride;
+        int step = stride == 8 ? 8 : stride * 2;
+        for (int e = 0, begin = 0; e < 4; begin = edgeEnd[e++]) {
+            for (int s = begin + first; s < edgeEnd[e]; s += step) {
+                sum += grad.at(pts[s].x, pts[s].y);
+                rest -= boundAt(pts[s]);
+            }
+        }
+        if (stride > 1 && hopeless()) return -1;
+    }
+    return sum / n;
+}
+
+// Scores candidates[first..] with their combined score, largest area
+// first, raising `best`.  Candidates that cannot reach `best` keep an
+// edgeScore of -1.
+static void scoreBounded(std::vector<Candidate>& candidates, size_t first,
+                         FrameContext& f, double& best) {
+    if (f.gradBound.empty()) f.gradBound = gradientBound(f.gray);
+    std::vector<Candidate*> order;
+    for (size_t i = first; i < candidates.size(); i++)
+        order.push_back(&candidates[i]);
+    std::sort(order.begin(), order.end(),
+        [](const Candidate* a, const Candidate* b) { return a->area > b->area; });
+
+    int abandoned = 0;
+    for (Candidate* c : order) {
+        double weight = c->area / f.imgArea;
+        double score = boundedEdgeScore(c->quad, f.grad, f.gradBound,
+                                        weight, best);
+        if (score < 0) {
+            c->edgeScore = -1;
+            abandoned++;
+            continue;
+        }
+        c->edgeScore = score * weight;
+        best = std::max(best, c->edgeScore);
+    }
+    LOGD("  bounded scoring: %d of %d abandoned",
+         abandoned, (int)order.size());
+    FrameTrace::mark("score");
+}
+
+// Runs every strategy, scoring each batch as it lands when bounded.
+static void runPipeline(FrameContext& f, std::vector<Candidate>& candidates) {
+    bool bounded = g_boundedScoring;
+    double best = 0;
+    for (int i = 0; i < STRATEGY_COUNT; i++)
+        runStrategy(STRATEGIES[i], f, candidates, !bounded);
+    if (bounded) scoreBounded(candidates, 0, f, best);
+}
+
+// Working-frame quad to input coordinates, TL TR BR BL.
+static std::vector<cv::Point> toInput(std::vector<cv::Point> quad,
+                                      double scale) {
+    for (auto& pt : quad) {
+        pt.x = (int)std::round(pt.x / scale);
+        pt.y = (int)std::round(pt.y / scale);
+    }
+    orderPoints(quad);
+    return quad;
+}
+
+std::vector<cv::Point> detectDocument(const cv::Mat& small, double scale,
+                                      bool earlyReject,
+                                      PageOrientation* orientation) {
+    LOGD("detectDocument: small=%dx%d scale=%.4f",
+         small.cols, small.rows, scale);
+
+    // A capture's colour planes all come out of the pass that makes
+    // gray; a live frame may still be rejected, so it gets gray alone
+    // and the rest once it passes.
+    FrameContext f;
+    bool all[STRATEGY_COUNT];
+    std::fill(all, all + STRATEGY_COUNT, true);
+    if (!earlyReject) expectPlanes(f, all);
+    if (!prepareFrame(small, earlyReject, f)) return {};
+    if (earlyReject) expectPlanes(f, all);
+    double imgArea = f.imgArea;
+
+    // Collect valid quad candidates from every strategy
+    std::vector<Candidate> candidates;
+    runPipeline(f, candidates);
+
+    if (candidates.empty()) {
+        LOGD("  RESULT: no candidates found");
+        return {};
+    }
+
+    auto& best = *std::max_element(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) {
+            return a.edgeScore < b.edgeScore;
+        });
+
+    LOGD("  BEST: combinedScore=%.1f area=%.0f (%.1f%%) corners=[%d,%d][%d,%d][%d,%d][%d,%d]",
+         best.edgeScore, best.area, best.area / imgArea * 100,
+         best.quad[0].x, best.quad[0].y, best.quad[1].x, best.quad[1].y,
+         best.quad[2].x, best.quad[2].y, best.quad[3].x, best.quad[3].y);
+
+    // Log top-5 candidates for debugging
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) {
+            return a.edgeScore > b.edgeScore;
+        });
+    int logN = std::min(5, (int)candidates.size());
+    for (int i = 0; i < logN; i++) {
+        auto& c = candidates[i];
+        LOGD("  top%d: combined=%.1f area=%.1f%%", i+1,
+             c.edgeScore, c.area / imgArea * 100);
+    }
+
+    // Scale back to original coordinates (candidates[0] is the best now)
+    auto result = toInput(candidates[0].quad, scale);
+    FrameTrace::mark("select");
+
+    if (orientation) {
+        cv::Point2f quad[4];
+        for (int i = 0; i < 4; i++)
+            quad[i] = cv::Point2f(result[i]) * (float)scale;
+        *orientation = estimateOrientation(f.grad, quad);
+        LOGD("  orientation: %d deg, confidence %.2f",
+             orientation->degrees, orientation->confidence);
+        FrameTrace::mark("orientation");
+    }
+
+    LOGD("  gradient tiles: %d of %d computed",
+         f.grad.tilesComputed(), f.grad.tileCount());
+    if (const PooledMatAllocator* pool = boundMatPool()) {
+        MatPoolStats ps = pool->stats();
+        LOGD("  mat pool: hits=%lld misses=%lld cached=%lldKB",
+             ps.hits, ps.misses, ps.cachedBytes >> 10);
+    }
+    return result;
+}
+
+// --- temporal mode ------------------------------------------------
+
+void TemporalDetector::fuse(std::vector<Candidate>& candidates,
+                            FrameContext& f) {
+    // Corners within 3% of the longer side count as the same document
+    double tol = 0.03 * std::max(f.gray.cols, f.gray.rows);
+    auto maxCornerDist = [](const std::vector<cv::Point>& a,
+                            const std::vector<cv::Point>& b) {
+        double d = 0;
+        for (int i = 0; i < 4; i++) d = std::max(d, cv::norm(a[i] - b[i]));
+        return d;
+    };
+
+    // Current evidence for every existing track
+    for (auto& t : tracks_) {
+        double now = computeEdgeScore(t.quad, f.grad) *
+                     cv::contourArea(t.quad) / f.imgArea;
+        t.score = DECAY * t.score + (1 - DECAY) * now;
+    }
+
+    for (auto& c : candidates) {
+        orderPoints(c.quad);
+        Track* match = nullptr;
+        for (auto& t : tracks_)
+            if (maxCornerDist(t.quad, c.quad) <= tol) { match = &t; break; }
+        if (!match) {
+            tracks_.push_back({c.quad, c.edgeScore, frame_});
+            continue;
+        }
+        match->lastConfirmed = frame_;
+        if (c.edgeScore > match->score) {
+            match->quad = c.quad;
+            match->score = c.edgeScore;
+        }
+    }
+
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+        [this](const Track& t) { return frame_ - t.lastConfirmed >= WINDOW; }),
+        tracks_.end());
+}
+
+std::vector<cv::Point> TemporalDetector::detect(const cv::Mat& small,
+                                                double scale) {
+    if (small.size() != size_) {
+        size_ = small.size();
+        tracks_.clear();
+    }
+    frame_++;
+
+    FrameContext f;
+    if (!prepareFrame(small, true, f)) {
+        tracks_.clear();
+        return {};
+    }
+
+    const int n = STRATEGY_COUNT;
+    std::vector<Candidate> candidates;
+    int64 start = cv::getTickCount();
+    for (int ran = 0; ran < n; ran++) {
+        double ms = (cv::getTickCount() - start) * 1000.0 /
+                    cv::getTickFrequency();
+        if (ran > 0 && ms >= budgetMs_) break;
+        runStrategy(STRATEGIES[cursor_], f, candidates);
+        cursor_ = (cursor_ + 1) % n;
+    }
+
+    fuse(candidates, f);
+    FrameTrace::mark("fuse");
+    if (tracks_.empty()) return {};
+
+    const Track& best = *std::max_element(tracks_.begin(), tracks_.end(),
+        [](const Track& a, const Track& b) { return a.score < b.score; });
+    LOGD("  temporal: %d tracks, best=%.1f", (int)tracks_.size(), best.score);
+    return toInput(best.quad, scale);
+}
+
+PageOrientation estimatePageOrientation(const cv::Mat& small, double scale,
+                                        const std::vector<cv::Point>& corners) {
+    if (corners.size() != 4) return PageOrientation();
+    ColorPlanes planes;
+    planes.compute(small, PLANE_GRAY);
+    cv::Point2f quad[4];
+    for (int i = 0; i < 4; i++)
+        quad[i] = cv::Point2f(corners[i]) * (float)scale;
+    GradientField grad(planes.gray);
+    return estimateOrientation(grad, quad);
+}
@@ -0,0 +1,136 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "orientation.h"
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// ===================================================================
+// Document detection on the ~600 px BGR working image produced by
+// StripIngest.  Corners come back in input coordinates, TL TR BR BL,
+// or empty when nothing plausible was found.
+// ===================================================================
+
+// Working resolution (longer side), pyramid level 0
+const int TARGET = 600;
+
+// Why a frame was dropped before any strategy ran.  Mirrored in
+// NativeScanner.REJECT_*.
+enum RejectReason {
+    REJECT_NONE = 0,
+    REJECT_LOW_CONTRAST = 1,       // no edge anywhere strong enough to trace
+    REJECT_NO_STRAIGHT_EDGES = 2,  // texture only, no two crossing lines
+};
+
+// Reason for the last detection result on the calling thread.
+RejectReason lastRejectReason();
+
+// Adaptive Canny thresholds instead of the fixed sweeps.  Process-wide,
+// on by default.
+void setAdaptiveCanny(bool enabled);
+
+// Score detectDocument() candidates largest first, coarse to fine, and
+// drop each as soon as it provably cannot beat the best so far.  The
+// winner is the one exhaustive scoring picks; only losers go unscored.
+// Process-wide, on by default.
+void setBoundedScoring(bool enabled);
+
+// Trace edge-map contours with traceOuterContours() instead of
+// cv::findContours(), keeping only the few approxQuads() looks at.
+// Process-wide, off until kernel_diff's outer_contours check has
+// passed on a desktop OpenCV build.
+void setStreamingContours(bool enabled);
+
+// Tunable constants of the candidate search.  The defaults are the
+// hand-picked values; scanner/src/test/cpp/tune_params.cpp measures
+// other profiles against recall, corner error and frame time.  A zero
+// entry in the two-pass arrays skips that pass.
+struct DetectorParams {
+    double minArea = 0.05;         // quad area, fraction of the frame
+    double maxArea = 0.85;
+    double maxCornerCos = 0.4;     // |cos| of the sharpest corner angle
+    int borderMargin = 5;          // px cleared / counted as "on the border"
+    int contourLimit = 20;         // largest contours approximated per map
+    double approxEps[2] = {0.02, 0.04};   // approxPolyDP, x perimeter
+    double cannyScale = 1.0;       // applied to every Canny low threshold
+    int gradientKernels[2] = {2, 3};      // morphological gradient, level 1
+    double claheClip = 3.0;
+};
+
+// Parameters for detections started after the call.  Process-wide.
+void setDetectorParams(const DetectorParams& params);
+DetectorParams detectorParams();
+
+// `small` is the BGR working image, `scale` its size relative to the
+// input.  `earlyReject` enables the quick "any document at all?" gate;
+// the live preview uses it, a deliberate capture always runs the full
+// pipeline.  With `orientation` set, the page's orientation is also
+// estimated inside the winning quad (left untouched when none wins).
+std::vector<cv::Point> detectDocument(const cv::Mat& small, double scale,
+                                      bool earlyReject,
+                                      PageOrientation* orientation = nullptr);
+
+// Orientation of the page at `corners` (input coordinates, as returned
+// by detectDocument) when detection was skipped.
+PageOrientation estimatePageOrientation(const cv::Mat& small, double scale,
+                                        const std::vector<cv::Point>& corners);
+
+struct Candidate;
+struct FrameContext;
+
+// Live preview detector that spreads the strategies over consecutive
+// frames.  Each frame runs the next strategies in round-robin order
+// until the time budget is spent (at least one), and the candidates
+// are fused into tracks that persist for a short window:
+//
+//  - a candidate whose corners all lie near a track's corners
+//    confirms it, and replaces its quad if it scores higher there;
+//  - every track's quad is re-scored on each new frame and its score
+//    is an exponential moving average, so stale or drifting quads fade;
+//  - tracks not confirmed by any strategy for WINDOW frames are dropped.
+//
+// A full cycle of strategies fits inside the window, so a steady scene
+// converges to the full-pipeline pick within a few frames.
+class TemporalDetector {
+public:
+    explicit TemporalDetector(double budgetMs) : budgetMs_(budgetMs) {}
+
+    std::vector<cv::Point> detect(const cv::Mat& small, double scale);
+    void reset() { tracks_.clear(); }
+
+private:
+    struct Track {
+        std::vector<cv::Point> quad;   // working frame, TL TR BR BL
+        double score;
+        int lastConfirmed;
+    };
+
+    static constexpr int WINDOW = 8;
+    static constexpr double DECAY = 0.6;   // weight of the history
+
+    void fuse(std::vector<Candidate>& candidates, FrameContext& f);
+
+    double budgetMs_;
+    int cursor_ = 0;
+    int frame_ = 0;
+    cv::Size size_;
+    std::vector<Track> tracks_;
+};
@@ -0,0 +1,191 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "flight_recorder.h"
+#include "scanner_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int RING = 64;
+const int MAX_SNAPSHOTS = 8;
+
+thread_local FrameTrace* t_current = nullptr;
+
+double msSince(int64 from, int64 to) {
+    return (to - from) * 1000.0 / cv::getTickFrequency();
+}
+
+struct Record {
+    long long seq;
+    const char* entry;
+    int width, height;
+    float totalMs;
+    int stages;
+    const char* names[FrameTrace::MAX_STAGES];
+    float ms[FrameTrace::MAX_STAGES];
+};
+
+// "#12 preview 600x450 total=31.2 ingest=2.1 prepare=3.0 ..."
+std::string formatRecord(const Record& r) {
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "#%lld %s %dx%d total=%.1f",
+                  r.seq, r.entry, r.width, r.height, r.totalMs);
+    std::string line = buf;
+    float marked = 0;
+    for (int i = 0; i < r.stages; i++) {
+        std::snprintf(buf, sizeof(buf), " %s=%.1f", r.names[i], r.ms[i]);
+        line += buf;
+        marked += r.ms[i];
+    }
+    if (r.totalMs - marked >= 0.05f) {
+        std::snprintf(buf, sizeof(buf), " other=%.1f", r.totalMs - marked);
+        line += buf;
+    }
+    return line;
+}
+
+// Binary PPM (RGB) from a BGR image.
+bool writePpm(const std::string& path, const cv::Mat& bgr) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "P6\n%d %d\n255\n", bgr.cols, bgr.rows);
+    std::vector<uchar> row(bgr.cols * 3);
+    bool ok = true;
+    for (int y = 0; y < bgr.rows && ok; y++) {
+        const uchar* p = bgr.ptr<uchar>(y);
+        for (int x = 0; x < bgr.cols * 3; x += 3) {
+            row[x] = p[x + 2];
+            row[x + 1] = p[x + 1];
+            row[x + 2] = p[x];
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), f) == row.size();
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+bool writeText(const std::string& path, const std::string& text) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+}  // namespace
+
+struct FlightRecorder {
+    std::mutex mutex;
+    Record ring[RING];
+    long long count = 0;
+    std::string dir;
+    double thresholdMs = 0;
+    int nextSlot = 0;
+    std::atomic<bool> writing{false};
+
+    static FlightRecorder& instance() {
+        static FlightRecorder recorder;
+        return recorder;
+    }
+
+    // Caller holds `mutex`.
+    std::string ringText() const {
+        std::string text;
+        for (long long s = std::max(0LL, count - RING); s < count; s++)
+            text += formatRecord(ring[s % RING]) + "\n";
+        return text;
+    }
+
+    void add(const FrameTrace& t, double totalMs) {
+        Record r;
+        r.entry = t.entry_;
+        r.width = t.input_.cols;
+        r.height = t.input_.rows;
+        r.totalMs = (float)totalMs;
+        r.stages = t.stages_;
+        std::copy(t.names_, t.names_ + t.stages_, r.names);
+        std::copy(t.ms_, t.ms_ + t.stages_, r.ms);
+
+        std::string path, report;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            r.seq = count;
+            ring[count++ % RING] = r;
+            if (thresholdMs <= 0 || totalMs <= thresholdMs) return;
+            LOGD("flight recorder: slow frame %s", formatRecord(r).c_str());
+            if (dir.empty() || t.input_.empty() || writing.exchange(true))
+                return;
+            path = dir + "/slow_" + std::to_string(nextSlot++ % MAX_SNAPSHOTS);
+            report = "slow: " + formatRecord(r) + "\n\nlast detections:\n" +
+                     ringText();
+        }
+
+        // The copy is the only cost left on the detecting thread
+        cv::Mat frame = t.input_.clone();
+        std::thread([this, path, report, frame] {
+            if (!writePpm(path + ".ppm", frame) ||
+                !writeText(path + ".txt", report))
+                LOGD("flight recorder: cannot write %s", path.c_str());
+            writing = false;
+        }).detach();
+    }
+};
+
+FrameTrace::FrameTrace(const char* entry)
+    : entry_(entry), start_(cv::getTickCount()), last_(start_),
+      outer_(t_current) {
+    t_current = this;
+}
+
+FrameTrace::~FrameTrace() {
+    t_current = outer_;
+    FlightRecorder::instance().add(*this,
+                                   msSince(start_, cv::getTickCount()));
+}
+
+void FrameTrace::mark(const char* stage) {
+    FrameTrace* t = t_current;
+    if (!t || t->stages_ >= MAX_STAGES) return;
+    int64 now = cv::getTickCount();
+    t->names_[t->stages_] = stage;
+    t->ms_[t->stages_++] = (float)msSince(t->last_, now);
+    t->last_ = now;
+}
+
+void FrameTrace::input(const cv::Mat& bgr) {
+    if (t_current) t_current->input_ = bgr;
+}
+
+void configureFlightRecorder(const std::string& dir, double thresholdMs) {
+    FlightRecorder& r = FlightRecorder::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.dir = dir;
+    r.thresholdMs = thresholdMs;
+}
+
+std::string dumpFlightRecorder() {
+    FlightRecorder& r = FlightRecorder::instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.ringText();
+}
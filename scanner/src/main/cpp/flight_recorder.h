@@ -0,0 +1,76 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <string>
+
+// ===================================================================
+// Slow-frame flight recorder.
+//
+// Every detection entry point opens a FrameTrace; pipeline stages mark
+// their end on the calling thread's trace, and the finished trace goes
+// into a process-wide ring of the last RING detections (a few clock
+// reads and one short lock per frame).  When a trace exceeds the
+// configured threshold, the working-resolution input is written as a
+// binary PPM next to a text report with its stage breakdown and the
+// ring around it.  Snapshots are written on a background thread, at
+// most one at a time, into MAX_SNAPSHOTS rotating slots.
+//
+// The PPMs load with cv::imread, so slow inputs pulled off a device
+// replay directly in the host harness (`kernel_diff --corpus`).
+// ===================================================================
+
+class FrameTrace {
+public:
+    // `entry` names the API that ran the detection.  Must be a string
+    // literal, as must every stage name.
+    explicit FrameTrace(const char* entry);
+    ~FrameTrace();
+
+    FrameTrace(const FrameTrace&) = delete;
+    FrameTrace& operator=(const FrameTrace&) = delete;
+
+    // Ends the current stage of this thread's trace; no-op without one.
+    static void mark(const char* stage);
+
+    // Working image (BGR) of this thread's trace, kept for a snapshot.
+    static void input(const cv::Mat& bgr);
+
+    static const int MAX_STAGES = 16;
+
+private:
+    friend struct FlightRecorder;
+
+    const char* entry_;
+    int64 start_, last_;
+    int stages_ = 0;
+    const char* names_[MAX_STAGES];
+    float ms_[MAX_STAGES];
+    cv::Mat input_;
+    FrameTrace* outer_;
+};
+
+// Snapshots go to `dir` (created by the caller); an empty `dir` keeps
+// the ring only.  `thresholdMs` <= 0 disables snapshots.
+void configureFlightRecorder(const std::string& dir, double thresholdMs);
+
+// The ring as text, oldest first: one line per detection.
+std::string dumpFlightRecorder();
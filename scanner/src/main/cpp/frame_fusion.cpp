@@ -0,0 +1,164 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_fusion.h"
+#include "scanner_log.h"
+
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+
+namespace {
+
+// Registration runs on a gray page with its longer side at most this.
+const int REGISTER = 512;
+// Phase-correlation peak below which a frame is not trusted to align.
+const double MIN_RESPONSE = 0.08;
+// Larger residual shifts (fraction of the page) mean a bad quad.
+const double MAX_SHIFT = 0.02;
+
+// Per-pixel, per-channel mean of `pages` without the lowest and
+// highest value once there are enough frames to spare them.
+void trimmedMean(const std::vector<cv::Mat>& pages, cv::Mat& out) {
+    const int k = (int)pages.size();
+    const int trim = k >= 4 ? 1 : 0, n = k - 2 * trim;
+    cv::parallel_for_(cv::Range(0, out.rows), [&](const cv::Range& r) {
+        const uchar* rows[FrameFusion::MAX_FRAMES];
+        uchar v[FrameFusion::MAX_FRAMES];
+        for (int y = r.start; y < r.end; y++) {
+            for (int i = 0; i < k; i++) rows[i] = pages[i].ptr<uchar>(y);
+            uchar* o = out.ptr<uchar>(y);
+            for (int x = 0; x < out.cols * 4; x += 4) {
+                for (int c = 0; c < 3; c++) {
+                    for (int i = 0; i < k; i++) {
+                        // Insertion sort: k is a handful
+                        uchar val = rows[i][x + c];
+                        int j = i;
+                        for (; j > 0 && v[j - 1] > val; j--) v[j] = v[j - 1];
+                        v[j] = val;
+                    }
+                    int sum = 0;
+                    for (int i = trim; i < k - trim; i++) sum += v[i];
+                    o[x + c] = (uchar)((sum + n / 2) / n);
+                }
+                o[x + 3] = 255;
+            }
+        }
+    });
+}
+
+}  // namespace
+
+void FrameFusion::push(const cv::Mat& frame, const std::vector<cv::Point>& quad) {
+    CV_Assert(quad.size() == 4);
+    Frame f;
+    f.image = frame.clone();
+    for (int i = 0; i < 4; i++) f.quad[i] = quad[i];
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!frames_.empty()) {
+        const cv::Point2f* last = frames_.back().quad;
+        double moved = 0;
+        for (int i = 0; i < 4; i++)
+            moved = std::max(moved, (double)cv::norm(f.quad[i] - last[i]));
+        if (moved > 0.25 * cv::norm(last[2] - last[0])) frames_.clear();
+    }
+    frames_.push_back(std::move(f));
+    while ((int)frames_.size() > capacity_) frames_.pop_front();
+}
+
+void FrameFusion::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_.clear();
+}
+
+int FrameFusion::render(EnhanceMode mode, cv::Mat& dst, int rotation) {
+    CV_Assert(dst.type() == CV_8UC4 && rotation % 90 == 0);
+    std::vector<Frame> frames;
+    {
+        // Frames are never written after push, sharing them is enough
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames.assign(frames_.begin(), frames_.end());
+    }
+    if (frames.empty()) return 0;
+
+    // Merge in the page's own orientation; the last pass turns it
+    bool turned = (rotation / 90) % 2 != 0;
+    int pw = turned ? dst.rows : dst.cols, ph = turned ? dst.cols : dst.rows;
+    const cv::Point2f corners[4] = {
+        {0.f, 0.f}, {(float)(pw - 1), 0.f},
+        {(float)(pw - 1), (float)(ph - 1)}, {0.f, (float)(ph - 1)}
+    };
+    std::vector<cv::Mat> none;
+    auto warp = [&](const cv::Mat& image, const cv::Point2f quad[4],
+                    cv::Mat& page) {
+        page.create(ph, pw, CV_8UC4);
+        return rectifyFused(image, quad, ENHANCE_NONE, page, none);
+    };
+
+    double rs = std::min(1.0, (double)REGISTER / std::max(pw, ph));
+    auto registration = [&](const cv::Mat& page) {
+        cv::Mat gray, f;
+        cv::cvtColor(page, gray, cv::COLOR_RGBA2GRAY);
+        if (rs < 1.0)
+            cv::resize(gray, gray, cv::Size(), rs, rs, cv::INTER_AREA);
+        gray.convertTo(f, CV_32F);
+        return f;
+    };
+
+    // The newest frame is the reference the others are aligned to
+    std::vector<cv::Mat> pages(1);
+    if (!warp(frames.back().image, frames.back().quad, pages[0])) return 0;
+    cv::Mat ref = registration(pages[0]), window;
+    cv::createHanningWindow(window, ref.size(), CV_32F);
+
+    for (size_t i = 0; i + 1 < frames.size(); i++) {
+        cv::Mat page;
+        if (!warp(frames[i].image, frames[i].quad, page)) {
+            LOGD("fusion: frame %d dropped (degenerate quad)", (int)i);
+            continue;
+        }
+        double response = 0;
+        cv::Point2d shift = cv::phaseCorrelate(ref, registration(page),
+                                               window, &response) / rs;
+        if (response < MIN_RESPONSE ||
+            cv::norm(shift) > MAX_SHIFT * std::max(pw, ph)) {
+            LOGD("fusion: frame %d dropped (response %.2f, shift %.1f,%.1f)",
+                 (int)i, response, shift.x, shift.y);
+            continue;
+        }
+        // This page is the reference moved by `shift`: sample the frame
+        // at the shifted page position instead
+        if (cv::norm(shift) > 0.1) {
+            cv::Mat h = cv::getPerspectiveTransform(corners, frames[i].quad);
+            std::vector<cv::Point2f> moved(4), quad(4);
+            for (int j = 0; j < 4; j++)
+                moved[j] = corners[j] + cv::Point2f(shift);
+            cv::perspectiveTransform(moved, quad, h);
+            if (!warp(frames[i].image, quad.data(), page)) continue;
+        }
+        pages.push_back(page);
+    }
+
+    cv::Mat merged(ph, pw, CV_8UC4);
+    trimmedMean(pages, merged);
+    if (!rectifyFused(merged, corners, mode, dst, none, rotation)) return 0;
+    LOGD("fusion: %d of %d frames merged into %dx%d",
+         (int)pages.size(), (int)frames.size(), dst.cols, dst.rows);
+    return (int)pages.size();
+}
@@ -0,0 +1,79 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "rectify.h"
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// ===================================================================
+// Multi-frame fused capture.
+//
+// Keeps the last few preview frames together with the document quad
+// tracked in each.  render() warps every frame onto the page plane
+// through its own quad, refines the registration against the newest
+// frame with phase correlation (sub-pixel translation, which is what
+// corner jitter between frames amounts to on the page), drops frames
+// that do not register, and merges the rest with a per-pixel trimmed
+// mean.  Averaging N frames cuts sensor noise by about sqrt(N); the
+// trim rejects a moving finger or a flicker of glare.
+//
+// The page comes out at whatever size the caller asks for: at the
+// preview's own resolution for an instant, clean scan, or somewhat
+// above it, where the sub-pixel offsets between frames add real
+// detail.  Enhancement and rotation are applied to the merged page in
+// a final rectifyFused() pass.
+// ===================================================================
+
+class FrameFusion {
+public:
+    static const int MAX_FRAMES = 16;
+
+    // Keeps up to `capacity` frames (at most MAX_FRAMES).
+    explicit FrameFusion(int capacity)
+        : capacity_(std::min(std::max(capacity, 1), MAX_FRAMES)) {}
+
+    // `frame` as for rectifyFused() (copied), `quad` TL TR BR BL in its
+    // pixels.  A quad far from the previous one means a new page: the
+    // older frames are dropped.
+    void push(const cv::Mat& frame, const std::vector<cv::Point>& quad);
+    void reset();
+
+    // Renders the fused page into `dst` (CV_8UC4, sized for the page
+    // after `rotation`).  Returns the number of frames merged, 0 when
+    // there is nothing to render, the newest frame's quad is degenerate
+    // or `mode` is not an EnhanceMode.  Older frames whose quad is
+    // degenerate are left out.
+    int render(EnhanceMode mode, cv::Mat& dst, int rotation = 0);
+
+private:
+    struct Frame {
+        cv::Mat image;
+        cv::Point2f quad[4];
+    };
+
+    const int capacity_;
+    std::mutex mutex_;
+    std::deque<Frame> frames_;
+};
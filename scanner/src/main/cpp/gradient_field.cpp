@@ -0,0 +1,92 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gradient_field.h"
+
+#include <algorithm>
+#include <cmath>
+
+GradientField::GradientField(const cv::Mat& img) : img_(img) {
+    CV_Assert(img.depth() == CV_8U &&
+              (img.channels() == 1 || img.channels() == 3 ||
+               img.channels() == 4));
+    tilesX_ = (img.cols + TILE - 1) / TILE;
+    int tilesY = (img.rows + TILE - 1) / TILE;
+    tiles_.resize((size_t)tilesX_ * tilesY);
+}
+
+// BORDER_REFLECT_101 for a coordinate at most one pixel outside
+static inline int reflect101(int i, int n) {
+    if (i < 0) return n > 1 ? 1 : 0;
+    if (i >= n) return n > 1 ? n - 2 : 0;
+    return i;
+}
+
+// cvtColor's 8-bit BGR/RGBA -> gray (R 0.299, G 0.587, B 0.114 in
+// 14-bit fixed point)
+int GradientField::luma(int x, int y) const {
+    const uchar* p = img_.ptr<uchar>(y) + x * img_.channels();
+    switch (img_.channels()) {
+        case 1:  return p[0];
+        case 3:  return (p[0] * 1868 + p[1] * 9617 + p[2] * 4899 + 8192) >> 14;
+        default: return (p[2] * 1868 + p[1] * 9617 + p[0] * 4899 + 8192) >> 14;
+    }
+}
+
+float GradientField::sample(int x, int y) const {
+    int W = img_.cols, H = img_.rows;
+    int xm = reflect101(x - 1, W), xp = reflect101(x + 1, W);
+    int ym = reflect101(y - 1, H), yp = reflect101(y + 1, H);
+    int a = luma(xm, ym), b = luma(x, ym), c = luma(xp, ym);
+    int d = luma(xm, y),                   f = luma(xp, y);
+    int g = luma(xm, yp), h = luma(x, yp), i = luma(xp, yp);
+    float gx = (float)((c + 2 * f + i) - (a + 2 * d + g));
+    float gy = (float)((g + 2 * h + i) - (a + 2 * b + c));
+    return std::sqrt(gx * gx + gy * gy);
+}
+
+void GradientField::computeTile(int t) {
+    int x0 = (t % tilesX_) * TILE, y0 = (t / tilesX_) * TILE;
+    int x1 = std::min(x0 + TILE, img_.cols), y1 = std::min(y0 + TILE, img_.rows);
+    int W = img_.cols, H = img_.rows;
+
+    // Luma of the tile plus a one-pixel reflected frame
+    const int S = TILE + 2;
+    int lum[S * S];
+    for (int y = y0 - 1; y <= y1; y++) {
+        int sy = reflect101(y, H);
+        for (int x = x0 - 1; x <= x1; x++)
+            lum[(y - y0 + 1) * S + (x - x0 + 1)] = luma(reflect101(x, W), sy);
+    }
+
+    std::vector<float>& out = tiles_[t];
+    out.assign(TILE * TILE, 0.f);
+    for (int y = 0; y < y1 - y0; y++) {
+        const int* r0 = lum + y * S;
+        const int* r1 = r0 + S;
+        const int* r2 = r1 + S;
+        for (int x = 0; x < x1 - x0; x++) {
+            float gx = (float)((r0[x + 2] + 2 * r1[x + 2] + r2[x + 2]) -
+                               (r0[x] + 2 * r1[x] + r2[x]));
+            float gy = (float)((r2[x] + 2 * r2[x + 1] + r2[x + 2]) -
+                               (r0[x] + 2 * r0[x + 1] + r0[x + 2]));
+            out[(y << TILE_SHIFT) + x] = std::sqrt(gx * gx + gy * gy);
+        }
+    }
+    computed_++;
+}
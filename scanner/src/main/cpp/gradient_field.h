@@ -0,0 +1,75 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// ===================================================================
+// Gradient magnitude evaluated on demand.
+//
+// Candidate scoring reads a few thousand pixels along quad edges, so
+// a dense Sobel over the frame is mostly wasted.  The field computes
+// 32 x 32 tiles the first time a pixel in them is read, or single
+// pixels without caching for sparse statistics.  Values are bit-exact
+// with cv::Sobel (3x3, CV_32F, BORDER_REFLECT_101) on x and y followed
+// by cv::magnitude.
+//
+// Colour sources (BGR, RGBA) are read through cvtColor's fixed-point
+// luma, so a full-resolution still can be scored in place with no gray
+// copy at all.
+// ===================================================================
+
+class GradientField {
+public:
+    GradientField() = default;
+
+    // `img` is CV_8UC1, CV_8UC3 (BGR) or CV_8UC4 (RGBA) and must stay
+    // alive while the field is used.
+    explicit GradientField(const cv::Mat& img);
+
+    int width() const { return img_.cols; }
+    int height() const { return img_.rows; }
+
+    // Cached: computes the surrounding tile on first use.
+    float at(int x, int y) {
+        int t = (y >> TILE_SHIFT) * tilesX_ + (x >> TILE_SHIFT);
+        if (tiles_[t].empty()) computeTile(t);
+        return tiles_[t][((y & TILE_MASK) << TILE_SHIFT) + (x & TILE_MASK)];
+    }
+
+    // Uncached single pixel, for sparse sampling.
+    float sample(int x, int y) const;
+
+    int tilesComputed() const { return computed_; }
+    int tileCount() const { return (int)tiles_.size(); }
+
+private:
+    static const int TILE_SHIFT = 5;
+    static const int TILE = 1 << TILE_SHIFT;
+    static const int TILE_MASK = TILE - 1;
+
+    int luma(int x, int y) const;
+    void computeTile(int t);
+
+    cv::Mat img_;
+    int tilesX_ = 0;
+    int computed_ = 0;
+    std::vector<std::vector<float>> tiles_;
+};
@@ -0,0 +1,102 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ingest.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstring>
+
+// Working image size for a source, with its longer side at `target`
+// (never upscaled), rounded the way cv::resize rounds a scale factor.
+static cv::Size workingSize(int srcW, int srcH, int target, double& scale) {
+    scale = 1.0;
+    if (std::max(srcW, srcH) <= target) return cv::Size(srcW, srcH);
+    scale = (double)target / std::max(srcW, srcH);
+    return cv::Size(std::max(1, cv::saturate_cast<int>(srcW * scale)),
+                    std::max(1, cv::saturate_cast<int>(srcH * scale)));
+}
+
+StripIngest::StripIngest(int srcW, int srcH, int target)
+    : srcW_(srcW), srcH_(srcH) {
+    CV_Assert(srcW > 0 && srcH > 0);
+    working_.create(workingSize(srcW, srcH, target, scale_), CV_8UC3);
+    sampler_.reset(new AreaDownsampler(srcW, srcH, working_));
+}
+
+static const int* channelMapFor(int cn) {
+    static const int RGBA_TO_BGR[3] = {2, 1, 0};
+    static const int BGR[3] = {0, 1, 2};
+    static const int GRAY[3] = {0, 0, 0};
+    return cn == 4 ? RGBA_TO_BGR : cn == 3 ? BGR : GRAY;
+}
+
+void StripIngest::push(const cv::Mat& strip) {
+    CV_Assert(strip.depth() == CV_8U && strip.cols > 0);
+    int cn = strip.channels();
+    const int* map = channelMapFor(cn);
+
+    for (int r = 0; r < strip.rows && nextRow_ < srcH_; r++, nextRow_++) {
+        const uchar* row = strip.ptr<uchar>(r);
+        if (strip.cols < srcW_) {
+            padded_.resize((size_t)srcW_ * cn);
+            std::memcpy(padded_.data(), row, (size_t)strip.cols * cn);
+            for (int x = strip.cols; x < srcW_; x++)
+                std::memcpy(&padded_[(size_t)x * cn],
+                            row + (size_t)(strip.cols - 1) * cn, cn);
+            row = padded_.data();
+        }
+        sampler_->addRow(nextRow_, row, cn, map);
+        if (r == strip.rows - 1 || nextRow_ == srcH_ - 1) {
+            lastRow_.assign(row, row + (size_t)srcW_ * cn);
+            lastCn_ = cn;
+        }
+    }
+}
+
+cv::Mat StripIngest::finish() {
+    // A short source (decoder stopped early) repeats its last row
+    if (nextRow_ == 0) {
+        working_.setTo(cv::Scalar::all(0));
+        return working_;
+    }
+    const int* map = channelMapFor(lastCn_);
+    for (; nextRow_ < srcH_; nextRow_++)
+        sampler_->addRow(nextRow_, lastRow_.data(), lastCn_, map);
+    sampler_->finish();
+    return working_;
+}
+
+cv::Mat ingestFrame(const cv::Mat& frame, int target, double& scale) {
+    CV_Assert(frame.depth() == CV_8U && !frame.empty());
+    cv::Size size = workingSize(frame.cols, frame.rows, target, scale);
+
+    // Shrink first, in the source's own layout, so the colour conversion
+    // only ever touches working-size pixels
+    cv::Mat small;
+    if (size == frame.size())
+        small = frame;
+    else
+        cv::resize(frame, small, size, 0, 0, cv::INTER_AREA);
+
+    int cn = frame.channels();
+    if (cn == 3) return small.data == frame.data ? small.clone() : small;
+    cv::Mat bgr;
+    cv::cvtColor(small, bgr, cn == 4 ? cv::COLOR_RGBA2BGR : cv::COLOR_GRAY2BGR);
+    return bgr;
+}
@@ -0,0 +1,73 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "area_resample.h"
+#include <opencv2/core.hpp>
+#include <memory>
+#include <vector>
+
+// ===================================================================
+// Streaming ingest for detection.
+//
+// The detector only ever looks at a ~600 px working image, but stills
+// arrive at 12-200 MP.  Converting the whole frame to BGR and then
+// resizing briefly holds two full-size buffers.  StripIngest instead
+// consumes the source a strip of rows at a time, converts and
+// area-averages each strip straight into the working image and keeps
+// nothing else, so peak memory is independent of sensor resolution.
+// It is for stills decoded a band at a time; frames already in memory
+// go through cv::resize (ingestFrame), which is vectorised and
+// parallel and needs no full-size copy either.
+// ===================================================================
+
+class StripIngest {
+public:
+    // Working image has its longer side at `target` (never upscaled),
+    // sized the way cv::resize rounds for the same scale factor.
+    StripIngest(int srcW, int srcH, int target);
+
+    int sourceWidth() const { return srcW_; }
+    int sourceHeight() const { return srcH_; }
+    double scale() const { return scale_; }
+
+    // Next rows of the source, top to bottom.  CV_8UC4 is RGBA (Android
+    // bitmaps), CV_8UC3 BGR, CV_8UC1 gray.  Extra columns are ignored,
+    // missing ones repeat the last pixel; rows past the source height
+    // are dropped.
+    void push(const cv::Mat& strip);
+
+    // BGR working image.  Missing rows repeat the last one pushed.
+    cv::Mat finish();
+
+private:
+    int srcW_, srcH_;
+    double scale_ = 1.0;
+    int nextRow_ = 0;
+    cv::Mat working_;
+    std::unique_ptr<AreaDownsampler> sampler_;
+    std::vector<uchar> padded_;   // one row widened to srcW_ if needed
+    std::vector<uchar> lastRow_;
+    int lastCn_ = 0;
+};
+
+// BGR working image for a frame that is already in memory (RGBA, BGR
+// or gray), sized as StripIngest sizes it: an INTER_AREA resize in the
+// frame's own layout, then the colour conversion at working size.
+cv::Mat ingestFrame(const cv::Mat& frame, int target, double& scale);
@@ -0,0 +1,316 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mat_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+thread_local const PooledMatAllocator* t_boundPool = nullptr;
+
+std::atomic<size_t> g_cacheLimit{SIZE_MAX};
+
+// Every pool alive, for globalStats(), and the hits and misses of those
+// already destroyed
+std::mutex g_registryMutex;
+std::vector<const PooledMatAllocator*> g_pools;
+long long g_goneHits = 0, g_goneMisses = 0;
+
+// Counter update by its only writer: no read-modify-write needed
+void bump(std::atomic<long long>& counter, long long delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta,
+                  std::memory_order_relaxed);
+}
+
+void raiseTo(std::atomic<long long>& peak, long long value) {
+    if (value > peak.load(std::memory_order_relaxed))
+        peak.store(value, std::memory_order_relaxed);
+}
+
+long long get(const std::atomic<long long>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+// Default allocator that defers to the pool bound to this thread.
+class RoutingAllocator : public cv::MatAllocator {
+public:
+    explicit RoutingAllocator(cv::MatAllocator* fallback)
+        : fallback_(fallback) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                           size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override {
+        const cv::MatAllocator* a =
+            t_boundPool ? t_boundPool : (const cv::MatAllocator*)fallback_;
+        return a->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData* data, cv::AccessFlag,
+                  cv::UMatUsageFlags) const override {
+        return data != nullptr;
+    }
+
+    // Blocks carry the allocator that made them in currAllocator, so
+    // this is only reached for foreign data.
+    void deallocate(cv::UMatData* data) const override {
+        if (data && data->currAllocator && data->currAllocator != this)
+            data->currAllocator->deallocate(data);
+    }
+
+private:
+    cv::MatAllocator* fallback_;
+};
+
+void installRouting() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        static RoutingAllocator routing(cv::Mat::getStdAllocator());
+        cv::Mat::setDefaultAllocator(&routing);
+    });
+}
+
+struct ThreadPoolHolder {
+    PooledMatAllocator* pool = nullptr;
+    ~ThreadPoolHolder() {
+        if (pool) pool->retire();
+    }
+};
+
+}  // namespace
+
+PooledMatAllocator::PooledMatAllocator(size_t maxCachedBytes)
+    : maxCached_(maxCachedBytes), owner_(std::this_thread::get_id()) {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    g_pools.push_back(this);
+}
+
+PooledMatAllocator::~PooledMatAllocator() {
+    trimCache();
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    g_pools.erase(std::find(g_pools.begin(), g_pools.end(), this));
+    g_goneHits += get(hits_);
+    g_goneMisses += get(misses_);
+}
+
+size_t PooledMatAllocator::sizeClass(size_t bytes) {
+    if (bytes <= 4096) return (bytes + 255) & ~(size_t)255;
+    size_t top = 4096;
+    while (top < bytes) top <<= 1;
+    size_t step = top / 16;   // 8 classes between top / 2 and top
+    return (bytes + step - 1) / step * step;
+}
+
+bool PooledMatAllocator::onOwner() const {
+    return std::this_thread::get_id() == owner_;
+}
+
+cv::UMatData* PooledMatAllocator::allocate(
+        int dims, const int* sizes, int type, void* data0, size_t* step,
+        cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    if (!onOwner() || retired_)
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0,
+                                                    step, flags, usageFlags);
+    takeRemote();
+
+    // Same step/size computation as OpenCV's StdMatAllocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data0 && step[i] != cv::Mat::AUTO_STEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->size = total;
+    if (data0) {
+        u->data = u->origdata = (uchar*)data0;
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    size_t cls = sizeClass(total);
+    void* block = nullptr;
+    auto it = free_.find(cls);
+    if (it != free_.end() && !it->second.empty()) {
+        block = it->second.back();
+        it->second.pop_back();
+        bump(cachedBytes_, -(long long)cls);
+        bump(hits_, 1);
+    } else {
+        block = cv::fastMalloc(cls);
+        bump(misses_, 1);
+    }
+    bump(live_, 1);
+    bump(liveBytes_, (long long)cls);
+    raiseTo(peakBytes_, get(liveBytes_));
+    raiseTo(maxBytes_, get(liveBytes_));
+    u->data = u->origdata = (uchar*)block;
+    return u;
+}
+
+bool PooledMatAllocator::allocate(cv::UMatData* data, cv::AccessFlag,
+                                  cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void PooledMatAllocator::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+    CV_Assert(u->urefcount == 0 && u->refcount == 0);
+    if (u->flags & cv::UMatData::USER_ALLOCATED) {
+        delete u;
+        return;
+    }
+
+    size_t cls = sizeClass(u->size);
+    void* block = u->origdata;
+    delete u;
+
+    if (onOwner() && !retired_) {
+        takeRemote();
+        release(block, cls);
+        return;
+    }
+
+    bool lastOfRetired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!retired_) {
+            remote_.push_back({block, cls});
+            remotePending_.store(true, std::memory_order_release);
+            return;
+        }
+        bump(live_, -1);
+        bump(liveBytes_, -(long long)cls);
+        lastOfRetired = get(live_) == 0;
+    }
+    cv::fastFree(block);
+    if (lastOfRetired) delete this;
+}
+
+// A block back on the owner thread: cached, or freed over the limit.
+void PooledMatAllocator::release(void* block, size_t cls) const {
+    bump(live_, -1);
+    bump(liveBytes_, -(long long)cls);
+    long long limit = (long long)std::min(
+        maxCached_, g_cacheLimit.load(std::memory_order_relaxed));
+    if (get(cachedBytes_) > limit) trimCache();
+    if (get(cachedBytes_) + (long long)cls <= limit) {
+        free_[cls].push_back(block);
+        bump(cachedBytes_, (long long)cls);
+    } else {
+        cv::fastFree(block);
+    }
+}
+
+// Owner thread: releases the blocks other threads handed back.
+void PooledMatAllocator::takeRemote() const {
+    if (!remotePending_.load(std::memory_order_acquire)) return;
+    std::vector<Block> blocks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks.swap(remote_);
+        remotePending_.store(false, std::memory_order_relaxed);
+    }
+    for (const Block& b : blocks) release(b.ptr, b.cls);
+}
+
+MatPoolStats PooledMatAllocator::stats() const {
+    return {get(hits_), get(misses_), get(cachedBytes_), get(live_),
+            get(liveBytes_), get(peakBytes_)};
+}
+
+void PooledMatAllocator::trim() const {
+    trimCache();
+}
+
+void PooledMatAllocator::trimCache() const {
+    for (auto& kv : free_)
+        for (void* p : kv.second) cv::fastFree(p);
+    free_.clear();
+    cachedBytes_.store(0, std::memory_order_relaxed);
+}
+
+void PooledMatAllocator::resetPeak() const {
+    peakBytes_.store(get(liveBytes_), std::memory_order_relaxed);
+}
+
+void PooledMatAllocator::setCacheLimit(size_t bytes) {
+    g_cacheLimit = bytes;
+}
+
+void PooledMatAllocator::retire() {
+    bool idle;
+    {
+        // From here on every thread takes the lock, so the counters
+        // keep a single writer at a time
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired_ = true;
+        for (const Block& b : remote_) {
+            cv::fastFree(b.ptr);
+            bump(live_, -1);
+            bump(liveBytes_, -(long long)b.cls);
+        }
+        remote_.clear();
+        trimCache();
+        idle = get(live_) == 0;
+    }
+    if (idle) delete this;
+}
+
+MatPoolStats PooledMatAllocator::globalStats() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    MatPoolStats total = {g_goneHits, g_goneMisses, 0, 0, 0, 0};
+    for (const PooledMatAllocator* p : g_pools) {
+        MatPoolStats s = p->stats();
+        total.hits += s.hits;
+        total.misses += s.misses;
+        total.cachedBytes += s.cachedBytes;
+        total.liveBlocks += s.liveBlocks;
+        total.liveBytes += s.liveBytes;
+        total.peakBytes += get(p->maxBytes_);
+    }
+    return total;
+}
+
+ScopedMatPool::ScopedMatPool(const PooledMatAllocator* pool)
+    : prev_(t_boundPool) {
+    installRouting();
+    t_boundPool = pool;
+}
+
+ScopedMatPool::~ScopedMatPool() {
+    t_boundPool = prev_;
+}
+
+const PooledMatAllocator* threadMatPool() {
+    static thread_local ThreadPoolHolder holder;
+    if (!holder.pool) holder.pool = new PooledMatAllocator();
+    return holder.pool;
+}
+
+const PooledMatAllocator* boundMatPool() {
+    return t_boundPool;
+}
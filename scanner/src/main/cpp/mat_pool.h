@@ -0,0 +1,146 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ===================================================================
+// Pooled cv::MatAllocator.
+//
+// A detection allocates the same few dozen working-resolution buffers
+// every frame, in our code and inside Canny, findContours, resize and
+// friends.  The pool keeps freed blocks in size classes (8 per
+// power of two, so at most 12.5% slack) and hands them straight back
+// on the next request: no malloc lock, no fresh page faults.
+//
+// OpenCV only has one process-wide default allocator, so a routing
+// allocator is installed as the default and forwards every request to
+// the pool bound to the calling thread (ScopedMatPool), or to the
+// standard allocator when none is bound.  Blocks always return to the
+// pool that produced them, whichever thread frees them.
+//
+// A pool belongs to the thread that constructs it.  That thread
+// allocates, recycles and counts without locks or shared counters;
+// other threads only hand blocks back, onto a locked list the owner
+// takes them from on its next call.  Bound on any other thread, or
+// once retired, a pool passes requests to the standard allocator.
+// ===================================================================
+
+struct MatPoolStats {
+    long long hits;          // served from cache
+    long long misses;        // had to allocate
+    long long cachedBytes;   // idle bytes held right now
+    long long liveBlocks;    // handed out and not yet returned
+    long long liveBytes;     // size of those blocks
+    long long peakBytes;     // highest liveBytes since resetPeak(); for
+                             // globalStats(), the sum of every live
+                             // pool's highest since it was created
+};
+
+class PooledMatAllocator : public cv::MatAllocator {
+public:
+    explicit PooledMatAllocator(size_t maxCachedBytes = 32u << 20);
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                           size_t* step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    // Safe from any thread.
+    MatPoolStats stats() const;
+
+    // Frees every idle block.  Owner thread only.
+    void trim() const;
+
+    // Restarts peakBytes from the current liveBytes.  Owner thread only.
+    void resetPeak() const;
+
+    // Process-wide ceiling on every pool's cache, below the size each
+    // was constructed with (memory budget mode).  Pools drop cached
+    // blocks above it on their next release.
+    static void setCacheLimit(size_t bytes);
+
+    // Replaces `delete`: frees the cache now and the allocator itself
+    // once the last outstanding block comes back.  Owner thread only.
+    void retire();
+
+    // Totals over every pool in the process.  Takes a process-wide
+    // lock; pools only take it when created and destroyed.
+    static MatPoolStats globalStats();
+
+private:
+    struct Block {
+        void* ptr;
+        size_t cls;
+    };
+
+    ~PooledMatAllocator() override;
+
+    static size_t sizeClass(size_t bytes);
+    bool onOwner() const;
+    void release(void* block, size_t cls) const;
+    void takeRemote() const;
+    void trimCache() const;
+
+    const size_t maxCached_;
+    const std::thread::id owner_;
+
+    // Owner thread only, or under mutex_ once retired
+    mutable std::map<size_t, std::vector<void*>> free_;
+    bool retired_ = false;
+
+    // Single writer (as above), so plain loads and stores; atomic only
+    // so that stats() can read them from other threads
+    mutable std::atomic<long long> hits_{0}, misses_{0}, cachedBytes_{0};
+    mutable std::atomic<long long> live_{0}, liveBytes_{0};
+    mutable std::atomic<long long> peakBytes_{0}, maxBytes_{0};
+
+    // Blocks other threads freed, for the owner to take back
+    mutable std::mutex mutex_;
+    mutable std::vector<Block> remote_;
+    mutable std::atomic<bool> remotePending_{false};
+};
+
+// Binds `pool` to the calling thread for the object's lifetime
+// (nesting restores the previous binding).  Installs the routing
+// allocator on first use.
+class ScopedMatPool {
+public:
+    explicit ScopedMatPool(const PooledMatAllocator* pool);
+    ~ScopedMatPool();
+    ScopedMatPool(const ScopedMatPool&) = delete;
+    ScopedMatPool& operator=(const ScopedMatPool&) = delete;
+
+private:
+    const PooledMatAllocator* prev_;
+};
+
+// Pool owned by the calling thread, created on first use and retired
+// when the thread exits.
+const PooledMatAllocator* threadMatPool();
+
+// Pool bound to the calling thread, or null.
+const PooledMatAllocator* boundMatPool();
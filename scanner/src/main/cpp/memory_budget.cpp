@@ -0,0 +1,190 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "memory_budget.h"
+#include "detector.h"
+#include "mat_pool.h"
+#include "scanner_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+namespace {
+
+std::atomic<size_t> g_budget{0};
+
+// Working sizes tried, largest first.  The last is a fallback only.
+const int WORKING_SIDES[] = {TARGET, 480, 400};
+const int FALLBACK_SIDE = 320;
+
+// Detection, per working pixel, before any has been measured: ~30
+// bytes counted at the largest strategy (Lab planes, their Canny maps
+// and Canny's own buffers on top of the working image, pyramid, gray
+// and gradient tiles), doubled for contour storage and pool slack.
+// Measurements only ever raise it.
+const long long DETECT_PRIOR_BYTES_PER_PIXEL = 64;
+const long long FIXED_BYTES = 8ll << 20;
+
+// Detection heap outside the Mat pool, per working pixel, at its worst
+// case (far above any real frame, but never exceeded):
+//  - contours: an outer border leaves a pixel at most once per run of
+//    set pixels around it, so at most 4 times, and CHAIN_APPROX_SIMPLE
+//    keeps at most one point per step: 32 B/px of points.  findContours
+//    holds them twice (its sequences, then the returned vectors); the
+//    tracer holds its kept contours and a chain buffer that growth may
+//    leave half empty.  96 B/px covers either, and the headers of
+//    specks (at most one in 4 pixels can be an isolated one);
+//  - run-length masks: a row holds at most w / 2 + 1 runs of 8 bytes,
+//    twice that after vector growth, so 8 B/px; at most 7 are live (six
+//    threshold levels at once, or a morphology chain and its window);
+//  - the flight recorder's snapshot of the working image (BGR), which
+//    can still be in flight during the next detection.
+const long long UNPOOLED_BYTES_PER_PIXEL = 96 + 7 * 8 + 3;
+
+// OpenCV threads while a budget is set, and the count it replaced
+const int BUDGET_THREADS = 1;
+int g_threadsBeforeBudget = 0;   // 0: no budget set
+std::mutex g_threadsMutex;
+
+std::atomic<long long> g_detectBytesPerPixel{DETECT_PRIOR_BYTES_PER_PIXEL};
+
+// Without a budget each pool keeps its constructed 32 MB.
+const size_t POOL_CACHE_MAX = 32u << 20;
+const size_t POOL_CACHE_SHARE = 16;   // of the budget
+
+// Working image size for a side, rounded as StripIngest rounds it.
+cv::Size workingSize(int w, int h, int side) {
+    if (std::max(w, h) <= side) return cv::Size(w, h);
+    double s = (double)side / std::max(w, h);
+    return cv::Size(std::max(1, cv::saturate_cast<int>(w * s)),
+                    std::max(1, cv::saturate_cast<int>(h * s)));
+}
+
+MemoryPlan planFor(int w, int h, int sample, int side) {
+    MemoryPlan plan;
+    plan.sample = sample;
+    plan.workingSide = side;
+    plan.pagePixels = (long long)w * h;
+    cv::Size work = workingSize(w, h, side);
+    long long source = plan.pagePixels * 4;
+    long long detection = detectionBytes(work.width, work.height) +
+                          unpooledDetectionBytes(work.width, work.height);
+    plan.peakBytes = source + FIXED_BYTES + std::max(detection, source) +
+                     (long long)poolCacheBytes();
+    if (sample > 1) plan.degraded |= DEGRADED_SOURCE;
+    if (side < TARGET && std::max(w, h) > side)
+        plan.degraded |= DEGRADED_WORKING_SIZE;
+    return plan;
+}
+
+}  // namespace
+
+void setMemoryBudget(size_t bytes) {
+    g_budget = bytes;
+    PooledMatAllocator::setCacheLimit(bytes ? poolCacheBytes() : SIZE_MAX);
+
+    std::lock_guard<std::mutex> lock(g_threadsMutex);
+    if (bytes && !g_threadsBeforeBudget) {
+        g_threadsBeforeBudget = std::max(1, cv::getNumThreads());
+        cv::setNumThreads(BUDGET_THREADS);
+    } else if (!bytes && g_threadsBeforeBudget) {
+        cv::setNumThreads(g_threadsBeforeBudget);
+        g_threadsBeforeBudget = 0;
+    }
+}
+
+size_t memoryBudget() {
+    return g_budget;
+}
+
+size_t poolCacheBytes() {
+    size_t budget = g_budget;
+    return budget ? std::min(POOL_CACHE_MAX, budget / POOL_CACHE_SHARE)
+                  : POOL_CACHE_MAX;
+}
+
+long long detectionBytes(int width, int height) {
+    return (long long)width * height * g_detectBytesPerPixel.load();
+}
+
+long long unpooledDetectionBytes(int width, int height) {
+    return (long long)width * height * UNPOOLED_BYTES_PER_PIXEL;
+}
+
+void recordDetection(cv::Size working, long long bytes) {
+    long long pixels = (long long)working.area();
+    if (pixels <= 0) return;
+    long long perPixel = (bytes + pixels - 1) / pixels;
+    long long model = g_detectBytesPerPixel.load();
+    while (perPixel > model &&
+           !g_detectBytesPerPixel.compare_exchange_weak(model, perPixel)) {}
+    if (perPixel > model)
+        LOGD("memory: detection took %lld B/px, model raised from %lld",
+             perPixel, model);
+}
+
+DetectionMeter::DetectionMeter(const PooledMatAllocator* pool)
+    : pool_(pool) {
+    pool_->resetPeak();
+    base_ = pool_->stats().liveBytes;
+}
+
+long long DetectionMeter::bytes(cv::Size working) const {
+    long long pooled = pool_->stats().peakBytes - base_;
+    return std::max(pooled, 0LL) +
+           (long long)working.area() * (3 + (long long)sizeof(float));
+}
+
+long long DetectionMeter::record(cv::Size working) const {
+    long long used = bytes(working);
+    recordDetection(working, used);
+    return used;
+}
+
+MemoryPlan planCapture(int width, int height, int maxSample) {
+    long long budget = (long long)memoryBudget();
+    if (!budget) return planFor(width, height, 1, TARGET);
+
+    for (int s = 1; s <= std::max(1, maxSample); s *= 2) {
+        // Decoders round subsampled sizes up
+        int w = (width + s - 1) / s, h = (height + s - 1) / s;
+        for (int side : WORKING_SIDES) {
+            MemoryPlan plan = planFor(w, h, s, side);
+            if (plan.peakBytes <= budget) return plan;
+        }
+    }
+    int s = 1;
+    while (s * 2 <= maxSample) s *= 2;
+    MemoryPlan plan = planFor((width + s - 1) / s, (height + s - 1) / s,
+                              s, FALLBACK_SIDE);
+    plan.fits = plan.peakBytes <= budget;
+    return plan;
+}
+
+cv::Size fitPage(MemoryPlan& plan, cv::Size page) {
+    long long area = (long long)page.width * page.height;
+    if (!memoryBudget() || area <= plan.pagePixels) return page;
+    double s = std::sqrt((double)plan.pagePixels / area);
+    plan.degraded |= DEGRADED_PAGE;
+    return cv::Size(std::max(1, (int)(page.width * s)),
+                    std::max(1, (int)(page.height * s)));
+}
@@ -0,0 +1,133 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+
+// ===================================================================
+// Memory budget for low-RAM devices.
+//
+// Every large buffer of a capture scales with the sensor: the decoded
+// still, the page rendered from it and, at the working size, the
+// detector's scratch.  With a budget set, a plan picks the decode
+// subsampling and the detector's working size so that the accounted
+// peak of a capture,
+//
+//     source + FIXED + max(detection, page) + pool cache
+//
+// stays under it, where
+//
+//  - source is the still as decoded (RGBA);
+//  - detection is the largest per-working-pixel peak measured so far
+//    (DetectionMeter) for everything the detector holds in Mats at
+//    once (working image, gradient tiles, pyramid, planes, strategy
+//    scratch, OpenCV's own temporaries), plus a worst-case reserve
+//    for what it holds outside the Mat pool (unpooledDetectionBytes);
+//  - page is reserved at the decoded source's pixel count; a page
+//    asking for more is scaled down to it (fitPage);
+//  - FIXED covers the drag preview source, thumbnails, the orientation
+//    patch, lookup tables, candidate lists and stacks;
+//  - pool cache is the per-pool cache ceiling set with the budget.
+//
+// While a budget is set OpenCV runs single-threaded: worker threads
+// have no Mat pool bound, so their temporaries would be neither
+// recycled nor measured.
+//
+// Quality is given up cheapest first: the working size steps down to
+// 480 and 400 px, then the decode subsampling doubles; 320 px is only
+// used when nothing else fits.  Each reduction is reported, and a
+// still that does not fit even then is refused (DEGRADED_OVER_BUDGET)
+// rather than detected over budget.
+//
+// The Mat term is measured, not proven: until the first metered
+// detection (warmUp() runs one) it is a 64 B/px prior, and a frame
+// heavier than every one before it can overshoot the plan once; the
+// model then rises for the next plan.
+// ===================================================================
+
+// What a plan gave up.  Mirrored in NativeScanner.DEGRADED_*.
+enum Degradation {
+    DEGRADED_NONE = 0,
+    DEGRADED_WORKING_SIZE = 1,   // detection ran below TARGET
+    DEGRADED_SOURCE = 2,         // still decoded subsampled
+    DEGRADED_PAGE = 4,           // page rendered below its native size
+    DEGRADED_PIPELINE = 8,       // session pages processed one at a time
+    DEGRADED_OVER_BUDGET = 16,   // not detected: no plan fits the budget
+};
+
+// Process-wide, in bytes; 0 (the default) means unbounded.  Also caps
+// every Mat pool's cache and OpenCV's thread count; lifting the budget
+// restores the thread count it found.
+void setMemoryBudget(size_t bytes);
+size_t memoryBudget();
+
+struct MemoryPlan {
+    int sample = 1;              // decode at 1/sample, a power of two
+    int workingSide = 0;         // detector working image, longer side
+    long long pagePixels = 0;    // largest page fitPage() lets through
+    long long peakBytes = 0;     // accounted peak of the plan
+    int degraded = DEGRADED_NONE;
+    bool fits = true;            // false: over budget even at its smallest
+};
+
+// Plan for a still of `width` x `height` pixels.  `maxSample` 1 plans
+// for a source that is already decoded.
+MemoryPlan planCapture(int width, int height, int maxSample = 16);
+
+// Detector memory model at a working image of `width` x `height`
+// (Mat pool cache excluded): the worst bytes per pixel measured so far
+// in this process, never below the prior.
+long long detectionBytes(int width, int height);
+
+// Heap the detector takes outside the Mat pool at a working image of
+// `width` x `height`, at its worst case: run-length masks, contour
+// points and the flight recorder's copy of the working image.
+long long unpooledDetectionBytes(int width, int height);
+
+// Folds a measured detection into the model.  Process-wide.
+void recordDetection(cv::Size working, long long bytes);
+
+class PooledMatAllocator;
+
+// Measures one detection: the peak of `pool` (bound to the thread
+// running it) above what was live at construction, plus the working
+// image and a full set of gradient tiles, which are live throughout
+// or not pooled.
+class DetectionMeter {
+public:
+    explicit DetectionMeter(const PooledMatAllocator* pool);
+
+    // Bytes the detection on a `working` image took; record() also
+    // passes them to recordDetection().
+    long long bytes(cv::Size working) const;
+    long long record(cv::Size working) const;
+
+private:
+    const PooledMatAllocator* pool_;
+    long long base_;
+};
+
+// Mat pool cache each pool may hold under the current budget.
+size_t poolCacheBytes();
+
+// `page` scaled down, aspect kept, to the plan's page reserve.  Marks
+// DEGRADED_PAGE in the plan when it had to.
+cv::Size fitPage(MemoryPlan& plan, cv::Size page);
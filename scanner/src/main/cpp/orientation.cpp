@@ -0,0 +1,171 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "orientation.h"
+#include "gradient_field.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Border trimmed from each side so the paper edge is not read as text.
+const double MARGIN = 0.04;
+// Half the Sobel magnitude below which nothing is a stroke.
+const int MIN_STROKE = 24;
+// Fraction of the mean row ink a text line's rows must reach.
+const double LINE_INK = 0.4;
+
+// Standard deviation over mean.
+double variation(const cv::Mat& profile) {
+    cv::Scalar mean, dev;
+    cv::meanStdDev(profile, mean, dev);
+    return mean[0] > 0 ? dev[0] / mean[0] : 0.0;
+}
+
+// Median absolute deviation: indented paragraphs do not spoil it.
+double spread(std::vector<int> v) {
+    auto mid = v.begin() + v.size() / 2;
+    std::nth_element(v.begin(), mid, v.end());
+    int median = *mid;
+    for (int& x : v) x = std::abs(x - median);
+    std::nth_element(v.begin(), mid, v.end());
+    return *mid;
+}
+
+// Evidence that the horizontal text lines of `ink` are upright: above
+// zero when upright, below when upside down, within [-1, 1].  `lines`
+// receives the number of text lines found.
+double uprightScore(const cv::Mat& ink, int& lines) {
+    cv::Mat rowSum;
+    cv::reduce(ink, rowSum, 1, cv::REDUCE_SUM, CV_32S);
+    std::vector<int> rows(ink.rows);
+    double mean = 0;
+    for (int y = 0; y < ink.rows; y++) {
+        rows[y] = rowSum.at<int>(y) / 255;
+        mean += rows[y];
+    }
+    mean /= ink.rows;
+    // Leaves the gaps between lines empty at working resolution, where
+    // a line is only a few rows tall
+    int t = std::max(1, (int)(mean * LINE_INK));
+
+    double above = 0, below = 0;
+    std::vector<int> starts, ends;
+    lines = 0;
+    for (int y = 0; y < ink.rows;) {
+        if (rows[y] < t) { y++; continue; }
+        int a = y;
+        while (y < ink.rows && rows[y] >= t) y++;
+        int b = y;
+        if (b - a < 3) continue;
+
+        // x-height core: the rows at least half as dense as the peak
+        int peak = *std::max_element(rows.begin() + a, rows.begin() + b);
+        int top = a, bot = b - 1;
+        while (rows[top] * 2 < peak) top++;
+        while (rows[bot] * 2 < peak) bot--;
+        for (int r = a; r < top; r++) above += rows[r];
+        for (int r = bot + 1; r < b; r++) below += rows[r];
+
+        int x0 = ink.cols, x1 = -1;
+        for (int r = a; r < b; r++) {
+            const uchar* p = ink.ptr<uchar>(r);
+            for (int x = 0; x < x0; x++)
+                if (p[x]) { x0 = x; break; }
+            for (int x = ink.cols - 1; x > x1; x--)
+                if (p[x]) { x1 = x; break; }
+        }
+        starts.push_back(x0);
+        ends.push_back(x1);
+        lines++;
+    }
+    if (lines < 2) return 0.0;
+
+    double ascent = (above - below) / (above + below + 1.0);
+    double sl = spread(starts), sr = spread(ends);
+    double ragged = (sr - sl) / (sr + sl + 1.0);
+    // Either cue alone is fooled too easily; no evidence unless both agree
+    if (ascent * ragged <= 0) return 0.0;
+    return 0.6 * ascent + 0.4 * ragged;
+}
+
+}  // namespace
+
+PageOrientation estimateOrientation(GradientField& grad,
+                                    const cv::Point2f quad[4]) {
+    PageOrientation result;
+
+    auto edge = [&](int a, int b) { return (double)cv::norm(quad[b] - quad[a]); };
+    int pw = (int)std::max(edge(0, 1), edge(3, 2));
+    int ph = (int)std::max(edge(0, 3), edge(1, 2));
+    if (pw < 32 || ph < 32) return result;
+    int mx = (int)(pw * MARGIN), my = (int)(ph * MARGIN);
+
+    // Only the page interior is sampled, from the detector's gradient
+    // tiles: no warp or Sobel of its own, and tiles already computed
+    // for detection are reused
+    cv::Point2f rect[4] = {
+        {(float)-mx, (float)-my}, {(float)(pw - 1 - mx), (float)-my},
+        {(float)(pw - 1 - mx), (float)(ph - 1 - my)}, {(float)-mx, (float)(ph - 1 - my)}
+    };
+    cv::Matx33d H = cv::getPerspectiveTransform(rect, quad);
+    cv::Mat mag(ph - 2 * my, pw - 2 * mx, CV_8UC1);
+    int maxX = grad.width() - 1, maxY = grad.height() - 1;
+    for (int v = 0; v < mag.rows; v++) {
+        uchar* out = mag.ptr<uchar>(v);
+        for (int u = 0; u < mag.cols; u++) {
+            double d = H(2, 0) * u + H(2, 1) * v + H(2, 2);
+            int x = cvRound((H(0, 0) * u + H(0, 1) * v + H(0, 2)) / d);
+            int y = cvRound((H(1, 0) * u + H(1, 1) * v + H(1, 2)) / d);
+            x = std::min(std::max(x, 0), maxX);
+            y = std::min(std::max(y, 0), maxY);
+            out[u] = cv::saturate_cast<uchar>(grad.at(x, y) * 0.5f);
+        }
+    }
+
+    cv::Mat ink;
+    double level = cv::threshold(mag, ink, 0, 255,
+                                 cv::THRESH_BINARY | cv::THRESH_OTSU);
+    if (level < MIN_STROKE) return result;
+    double inkFraction = (double)cv::countNonZero(ink) / ink.total();
+    if (inkFraction < 0.01 || inkFraction > 0.5) return result;
+
+    // Axis: text lines make the row profile alternate
+    cv::Mat rowSum, colSum;
+    cv::reduce(ink, rowSum, 1, cv::REDUCE_SUM, CV_32S);
+    cv::reduce(ink, colSum, 0, cv::REDUCE_SUM, CV_32S);
+    double axis = std::log((variation(rowSum) + 1e-3) /
+                           (variation(colSum) + 1e-3));
+    bool horizontal = axis >= 0;
+
+    // Direction, on lines turned horizontal if needed
+    cv::Mat lines = ink;
+    if (!horizontal) cv::rotate(ink, lines, cv::ROTATE_90_CLOCKWISE);
+    int n;
+    double up = uprightScore(lines, n);
+    if (n < 2) return result;
+
+    result.degrees = horizontal ? (up >= 0 ? 0 : 180) : (up >= 0 ? 90 : 270);
+    result.confidence = (float)std::min(std::min(1.0, std::abs(axis) / 0.4),
+                                        std::min(1.0, std::abs(up) / 0.25));
+    return result;
+}
@@ -0,0 +1,57 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+
+// ===================================================================
+// Page orientation from text layout, at detection resolution.
+//
+// The page interior is sampled from the detector's gradient field (a
+// few hundred pixels a side) and its text strokes are binarised from
+// the magnitude.  Two statistics then decide the orientation:
+//
+//  - axis: text lines make the row projection profile alternate much
+//    more than the column profile, which tells 0/180 from 90/270.
+//  - direction: once lines run horizontally, ink above each line's
+//    x-height core (ascenders, capitals) outweighs ink below it
+//    (descenders), and line starts align on the left while line ends
+//    are ragged.  Both flip sign when the page is upside down, and
+//    both must agree.
+//
+// Pages without enough text come back with confidence 0.
+// ===================================================================
+
+struct PageOrientation {
+    int degrees = 0;          // clockwise turn that makes the page upright
+    float confidence = 0.f;   // 0..1
+};
+
+// Below this the estimate is a guess; keep the page as captured.
+// kernel_diff checks that nothing above it is wrong on rotated text
+// pages; in a model of that check the first wrong answer sat below 0.5.
+const float ORIENTATION_MIN_CONFIDENCE = 0.6f;
+
+class GradientField;
+
+// `grad` is the gradient field of the working image, `quad` the page
+// corners in it, TL TR BR BL as captured.
+PageOrientation estimateOrientation(GradientField& grad,
+                                    const cv::Point2f quad[4]);
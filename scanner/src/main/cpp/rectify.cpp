@@ -0,0 +1,290 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rectify.h"
+#include "area_resample.h"
+
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Output tiles are small enough that the source footprint of one tile
+// (a skewed parallelogram) stays in L1/L2 while it is being sampled.
+const int TILE = 64;
+
+// Byte offsets of R, G, B inside one source pixel.
+struct ChannelLayout {
+    int cn;
+    int r, g, b;
+};
+
+ChannelLayout layoutOf(const cv::Mat& src) {
+    switch (src.channels()) {
+        case 4:  return {4, 0, 1, 2};
+        case 3:  return {3, 2, 1, 0};
+        default: return {1, 0, 0, 0};
+    }
+}
+
+inline int luma(int r, int g, int b) {
+    return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// Maps destination pixels to source coordinates.
+struct InverseMap {
+    double m[9];
+
+    InverseMap() = default;
+    explicit InverseMap(const cv::Mat& h) {
+        for (int i = 0; i < 9; i++) m[i] = h.at<double>(i / 3, i % 3);
+    }
+
+    cv::Point2f operator()(double x, double y) const {
+        double w = m[6] * x + m[7] * y + m[8];
+        return {(float)((m[0] * x + m[1] * y + m[2]) / w),
+                (float)((m[3] * x + m[4] * y + m[5]) / w)};
+    }
+};
+
+// Builds the map from a W x H output onto `quad` (the output corners
+// in TL TR BR BL order).  Fails when the quad has a non-finite corner,
+// three collinear corners or a fold (self-intersecting or concave):
+// the homography is then singular, or its denominator changes sign
+// inside the output and X / W goes infinite or NaN.  The denominator
+// is linear in x and y, so positive at the four output corners means
+// positive everywhere between them.
+bool mapOutput(const cv::Point2f quad[4], int W, int H, InverseMap& map) {
+    if (W < 2 || H < 2) return false;
+    for (int i = 0; i < 4; i++)
+        if (!std::isfinite(quad[i].x) || !std::isfinite(quad[i].y))
+            return false;
+    cv::Point2f dstPts[4] = {
+        {0.f, 0.f}, {(float)(W - 1), 0.f},
+        {(float)(W - 1), (float)(H - 1)}, {0.f, (float)(H - 1)}
+    };
+    cv::Mat h = cv::getPerspectiveTransform(dstPts, quad);
+    if (!cv::checkRange(h) || cv::determinant(h) == 0) return false;
+    map = InverseMap(h);
+    for (int i = 0; i < 4; i++) {
+        double w = map.m[6] * dstPts[i].x + map.m[7] * dstPts[i].y + map.m[8];
+        if (!(w > 1e-9)) return false;
+    }
+    return true;
+}
+
+// Levels stretch: 1st..99th percentile of a sparse sample of the page
+// mapped to 0..255.  Low-range channels are left alone so a blank
+// page does not turn into amplified sensor noise.
+void buildStretchLut(const int hist[256], int total, uchar lut[256]) {
+    int lo = 0, hi = 255, acc = 0, cut = total / 100;
+    while (lo < 255 && (acc += hist[lo]) <= cut) lo++;
+    acc = 0;
+    while (hi > 0 && (acc += hist[hi]) <= cut) hi--;
+    if (hi - lo < 32) {
+        for (int v = 0; v < 256; v++) lut[v] = (uchar)v;
+        return;
+    }
+    for (int v = 0; v < 256; v++)
+        lut[v] = cv::saturate_cast<uchar>((v - lo) * 255.0 / (hi - lo));
+}
+
+// Per-channel LUTs (R, G, B) for the requested mode, built from a
+// 64 x 64 grid of nearest-neighbour samples inside the page.
+void buildLuts(const cv::Mat& src, const ChannelLayout& L,
+               const InverseMap& map, int dstW, int dstH,
+               EnhanceMode mode, uchar luts[3][256]) {
+    if (mode == ENHANCE_NONE) {
+        for (int c = 0; c < 3; c++)
+            for (int v = 0; v < 256; v++) luts[c][v] = (uchar)v;
+        return;
+    }
+
+    int hist[4][256] = {};
+    const int GRID = 64;
+    for (int gy = 0; gy < GRID; gy++) {
+        for (int gx = 0; gx < GRID; gx++) {
+            cv::Point2f p = map((gx + 0.5) * dstW / GRID,
+                                (gy + 0.5) * dstH / GRID);
+            int x = std::min(std::max((int)p.x, 0), src.cols - 1);
+            int y = std::min(std::max((int)p.y, 0), src.rows - 1);
+            const uchar* px = src.ptr<uchar>(y) + x * L.cn;
+            hist[0][px[L.r]]++;
+            hist[1][px[L.g]]++;
+            hist[2][px[L.b]]++;
+            hist[3][luma(px[L.r], px[L.g], px[L.b])]++;
+        }
+    }
+    if (mode == ENHANCE_GRAY) {
+        buildStretchLut(hist[3], GRID * GRID, luts[0]);
+        std::copy(luts[0], luts[0] + 256, luts[1]);
+        std::copy(luts[0], luts[0] + 256, luts[2]);
+    } else {
+        for (int c = 0; c < 3; c++)
+            buildStretchLut(hist[c], GRID * GRID, luts[c]);
+    }
+}
+
+// Renders output rows [y0, y1) x columns [x0, x1).
+void renderTile(const cv::Mat& src, const ChannelLayout& L,
+                const InverseMap& map, const uchar luts[3][256],
+                bool gray, cv::Mat& dst, int x0, int x1, int y0, int y1) {
+    const float maxX = (float)(src.cols - 1), maxY = (float)(src.rows - 1);
+    const size_t step = src.step;
+    const uchar* base = src.data;
+
+    for (int y = y0; y < y1; y++) {
+        uchar* out = dst.ptr<uchar>(y) + x0 * 4;
+        // Homogeneous source coordinates step linearly along a row
+        double X = map.m[0] * x0 + map.m[1] * y + map.m[2];
+        double Y = map.m[3] * x0 + map.m[4] * y + map.m[5];
+        double W = map.m[6] * x0 + map.m[7] * y + map.m[8];
+        for (int x = x0; x < x1; x++, out += 4,
+             X += map.m[0], Y += map.m[3], W += map.m[6]) {
+            float fx = std::min(std::max((float)(X / W), 0.f), maxX);
+            float fy = std::min(std::max((float)(Y / W), 0.f), maxY);
+            int ix = std::min((int)fx, src.cols - 2);
+            int iy = std::min((int)fy, src.rows - 2);
+            ix = std::max(ix, 0);
+            iy = std::max(iy, 0);
+            float ax = fx - ix, ay = fy - iy;
+
+            const uchar* p00 = base + iy * step + ix * L.cn;
+            const uchar* p01 = p00 + (src.cols > 1 ? L.cn : 0);
+            const uchar* p10 = p00 + (src.rows > 1 ? step : 0);
+            const uchar* p11 = p10 + (src.cols > 1 ? L.cn : 0);
+            auto sample = [&](int o) {
+                float top = p00[o] + ax * (p01[o] - p00[o]);
+                float bot = p10[o] + ax * (p11[o] - p10[o]);
+                return (int)(top + ay * (bot - top) + 0.5f);
+            };
+
+            int r = sample(L.r), g = sample(L.g), b = sample(L.b);
+            if (gray) r = g = b = luma(r, g, b);
+            out[0] = luts[0][r];
+            out[1] = luts[1][g];
+            out[2] = luts[2][b];
+            out[3] = 255;
+        }
+    }
+}
+
+}  // namespace
+
+bool rectifyFused(const cv::Mat& src, const cv::Point2f quad[4],
+                  EnhanceMode mode, cv::Mat& dst,
+                  std::vector<cv::Mat>& downsampled, int rotation) {
+    CV_Assert(src.depth() == CV_8U && dst.type() == CV_8UC4);
+    CV_Assert(rotation % 90 == 0);
+    if (!isEnhanceMode(mode)) return false;
+    int W = dst.cols, H = dst.rows;
+    // A clockwise quarter turn puts the page's BL corner at output TL
+    int k = ((rotation / 90) % 4 + 4) % 4;
+    cv::Point2f turned[4];
+    for (int i = 0; i < 4; i++) turned[i] = quad[(i + 4 - k) % 4];
+    InverseMap map;
+    if (!mapOutput(turned, W, H, map)) return false;
+    ChannelLayout L = layoutOf(src);
+
+    uchar luts[3][256];
+    buildLuts(src, L, map, W, H, mode, luts);
+    bool gray = mode == ENHANCE_GRAY || L.cn == 1;
+
+    static const int RGBA[4] = {0, 1, 2, 3};
+    std::vector<AreaDownsampler> pyramid;
+    pyramid.reserve(downsampled.size());
+    for (auto& m : downsampled) pyramid.emplace_back(W, H, m);
+
+    // One band of tiles at a time, so a finished band can feed the
+    // smaller outputs before it leaves the cache.
+    int tilesX = (W + TILE - 1) / TILE;
+    for (int y0 = 0; y0 < H; y0 += TILE) {
+        int y1 = std::min(y0 + TILE, H);
+        cv::parallel_for_(cv::Range(0, tilesX), [&](const cv::Range& r) {
+            for (int t = r.start; t < r.end; t++) {
+                int x0 = t * TILE;
+                renderTile(src, L, map, luts, gray, dst,
+                           x0, std::min(x0 + TILE, W), y0, y1);
+            }
+        });
+        if (pyramid.empty()) continue;
+        cv::parallel_for_(cv::Range(0, (int)pyramid.size()),
+            [&](const cv::Range& r) {
+                for (int i = r.start; i < r.end; i++)
+                    for (int y = y0; y < y1; y++)
+                        pyramid[i].addRow(y, dst.ptr<uchar>(y), 4, RGBA);
+            });
+    }
+    for (auto& p : pyramid) p.finish();
+    return true;
+}
+
+// --- preview ------------------------------------------------------
+
+PreviewRectifier::PreviewRectifier(const cv::Mat& src, int maxSide) {
+    CV_Assert(src.depth() == CV_8U);
+    scale_ = std::min(1.0, (double)maxSide / std::max(src.cols, src.rows));
+    if (scale_ < 1.0)
+        cv::resize(src, src_, cv::Size(), scale_, scale_, cv::INTER_AREA);
+    else
+        src_ = src.clone();
+}
+
+int PreviewRectifier::render(const cv::Point2f quad[4], cv::Mat& dst) {
+    CV_Assert(dst.type() == CV_8UC4);
+    int W = dst.cols, H = dst.rows;
+    cv::Point2f q[4];
+    for (int i = 0; i < 4; i++) q[i] = quad[i] * (float)scale_;
+    InverseMap map;
+    if (!mapOutput(q, W, H, map)) return -1;
+    ChannelLayout L = layoutOf(src_);
+
+    uchar identity[3][256];   // preview shows the plain warp
+    buildLuts(src_, L, map, W, H, ENHANCE_NONE, identity);
+
+    int tilesX = (W + TILE - 1) / TILE, tilesY = (H + TILE - 1) / TILE;
+    bool full = dst.data != lastData_ || dst.size() != lastSize_;
+    if (full) rendered_.assign((size_t)tilesX * tilesY * 4, cv::Point2f());
+    lastData_ = dst.data;
+    lastSize_ = dst.size();
+
+    // A quarter pixel of drift is invisible after bilinear sampling
+    const float TOL2 = 0.25f * 0.25f;
+    int count = 0;
+    for (int ty = 0; ty < tilesY; ty++) {
+        int y0 = ty * TILE, y1 = std::min(y0 + TILE, H);
+        for (int tx = 0; tx < tilesX; tx++) {
+            int x0 = tx * TILE, x1 = std::min(x0 + TILE, W);
+            cv::Point2f now[4] = {
+                map(x0, y0), map(x1 - 1, y0), map(x1 - 1, y1 - 1), map(x0, y1 - 1)
+            };
+            cv::Point2f* old = &rendered_[((size_t)ty * tilesX + tx) * 4];
+            bool dirty = full;
+            for (int i = 0; i < 4 && !dirty; i++) {
+                cv::Point2f d = now[i] - old[i];
+                dirty = d.dot(d) > TOL2;
+            }
+            if (!dirty) continue;
+            renderTile(src_, L, map, identity, L.cn == 1, dst, x0, x1, y0, y1);
+            std::copy(now, now + 4, old);
+            count++;
+        }
+    }
+    return count;
+}
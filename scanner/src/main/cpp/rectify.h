@@ -0,0 +1,99 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// ===================================================================
+// Fused rectification: perspective warp, enhancement and RGBA packing
+// in a single pass over the output.
+//
+// Each output tile is produced by inverse-mapping every pixel through
+// the homography, sampling the source bilinearly, running the result
+// through a per-channel lookup table and storing RGBA straight into
+// the destination (typically a locked Android Bitmap).  No full-size
+// intermediate is ever allocated.
+//
+// Smaller renditions (screen preview, list thumbnail) are produced in
+// the same pass: each finished band of output rows is area-averaged
+// into every extra output while it is still in cache, so the page is
+// never read back.
+// ===================================================================
+
+// Mirrored in NativeScanner.ENHANCE_*.
+enum EnhanceMode {
+    ENHANCE_NONE = 0,    // plain warp
+    ENHANCE_COLOR = 1,   // per-channel levels stretch (also white-balances)
+    ENHANCE_GRAY = 2,    // luma with levels stretch
+};
+
+// Whether `mode` (e.g. an int from Java) names an EnhanceMode.
+inline bool isEnhanceMode(int mode) {
+    return mode >= ENHANCE_NONE && mode <= ENHANCE_GRAY;
+}
+
+// `src` is CV_8UC4 (RGBA, as Android bitmaps), CV_8UC3 (BGR) or
+// CV_8UC1.  `quad` holds the page corners TL, TR, BR, BL in source
+// pixels.  `dst` must be CV_8UC4 and receives RGBA.  Every entry of
+// `downsampled` is a CV_8UC4 target no larger than `dst` in either
+// dimension; it receives the area-averaged page at its own size.
+// `rotation` (0, 90, 180 or 270) turns the page clockwise during the
+// warp at no cost; `dst` is then sized for the turned page.
+// Returns false, leaving every output untouched, when `mode` is not an
+// EnhanceMode or no homography maps the output onto `quad`: a corner
+// is not finite, three corners are collinear, the quad folds over
+// itself or is concave, or `dst` is narrower than 2 px.
+bool rectifyFused(const cv::Mat& src, const cv::Point2f quad[4],
+                  EnhanceMode mode, cv::Mat& dst,
+                  std::vector<cv::Mat>& downsampled, int rotation = 0);
+
+// ===================================================================
+// Live rectified preview while a corner is being dragged.
+//
+// The source is area-downsampled once; each render warps it into a
+// small destination in tiles.  A tile is re-rendered only when the
+// source position of one of its corners moved by more than a fraction
+// of a preview-source pixel since that tile was last drawn, so a drag
+// only repaints the part of the page near the moving corner (the far
+// side barely shifts at preview resolution).
+// ===================================================================
+
+class PreviewRectifier {
+public:
+    // `src` as for rectifyFused().  The copy kept has its longer side
+    // limited to `maxSide`.
+    PreviewRectifier(const cv::Mat& src, int maxSide);
+
+    // `quad` in full-resolution source pixels.  `dst` is CV_8UC4 and
+    // must keep its contents between calls (clean tiles are not
+    // touched); a different buffer or size forces a full render.
+    // Returns the number of tiles rendered, or -1 (nothing touched) for
+    // a quad rectifyFused() would reject.
+    int render(const cv::Point2f quad[4], cv::Mat& dst);
+
+private:
+    static const int TILE = 16;
+
+    cv::Mat src_;
+    double scale_;
+    const uchar* lastData_ = nullptr;
+    cv::Size lastSize_;
+    std::vector<cv::Point2f> rendered_;   // 4 source corners per tile
+};
@@ -0,0 +1,203 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "rle_mask.h"
+
+#include <algorithm>
+
+// --- construction -------------------------------------------------
+
+// Appends runs row by row.  Runs must arrive in ascending start order
+// within a row; overlapping or touching runs are merged on the fly.
+class RleMask::Builder {
+public:
+    Builder(int w, int h) {
+        m_.w_ = w;
+        m_.h_ = h;
+        m_.rowStart_.reserve(h + 1);
+        m_.rowStart_.push_back(0);
+    }
+
+    void add(int start, int end) {
+        if (end <= start) return;
+        if ((int)m_.runs_.size() > m_.rowStart_.back() &&
+            m_.runs_.back().end >= start) {
+            m_.runs_.back().end = std::max(m_.runs_.back().end, end);
+            return;
+        }
+        m_.runs_.push_back({start, end});
+    }
+
+    void endRow() { m_.rowStart_.push_back((int)m_.runs_.size()); }
+
+    RleMask finish() { return std::move(m_); }
+
+private:
+    RleMask m_;
+};
+
+RleMask RleMask::fromMask(const cv::Mat& mask) {
+    CV_Assert(mask.type() == CV_8UC1);
+    Builder b(mask.cols, mask.rows);
+    for (int y = 0; y < mask.rows; y++) {
+        const uchar* row = mask.ptr<uchar>(y);
+        int x = 0;
+        while (x < mask.cols) {
+            while (x < mask.cols && !row[x]) x++;
+            int start = x;
+            while (x < mask.cols && row[x]) x++;
+            b.add(start, x);
+        }
+        b.endRow();
+    }
+    return b.finish();
+}
+
+void RleMask::thresholdLevels(const cv::Mat& gray, const int* thresholds,
+                              int numLevels, RleMask* out) {
+    CV_Assert(gray.type() == CV_8UC1 && numLevels > 0);
+
+    // level[v] = number of thresholds <= v.  Because thresholds ascend,
+    // a pixel is set in exactly the first level[v] masks, so a change of
+    // level opens or closes a contiguous range of runs.
+    uchar level[256];
+    for (int v = 0; v < 256; v++) {
+        int k = 0;
+        while (k < numLevels && thresholds[k] <= v) k++;
+        level[v] = (uchar)k;
+    }
+
+    std::vector<Builder> builders;
+    builders.reserve(numLevels);
+    for (int l = 0; l < numLevels; l++)
+        builders.emplace_back(gray.cols, gray.rows);
+    std::vector<int> open(numLevels);
+
+    for (int y = 0; y < gray.rows; y++) {
+        const uchar* row = gray.ptr<uchar>(y);
+        int prev = 0;
+        for (int x = 0; x < gray.cols; x++) {
+            int k = level[row[x]];
+            if (k == prev) continue;
+            if (k > prev) {
+                for (int l = prev; l < k; l++) open[l] = x;
+            } else {
+                for (int l = k; l < prev; l++) builders[l].add(open[l], x);
+            }
+            prev = k;
+        }
+        for (int l = 0; l < prev; l++) builders[l].add(open[l], gray.cols);
+        for (auto& b : builders) b.endRow();
+    }
+    for (int l = 0; l < numLevels; l++) out[l] = builders[l].finish();
+}
+
+cv::Mat RleMask::toMat() const {
+    cv::Mat m = cv::Mat::zeros(h_, w_, CV_8UC1);
+    for (int y = 0; y < h_; y++) {
+        uchar* row = m.ptr<uchar>(y);
+        for (const Run* r = rowBegin(y); r != rowEnd(y); ++r)
+            std::fill(row + r->start, row + r->end, (uchar)255);
+    }
+    return m;
+}
+
+void RleMask::clearBorder(int border) {
+    Builder b(w_, h_);
+    for (int y = 0; y < h_; y++) {
+        if (y >= border && y < h_ - border) {
+            for (const Run* r = rowBegin(y); r != rowEnd(y); ++r)
+                b.add(std::max(r->start, border),
+                      std::min(r->end, w_ - border));
+        }
+        b.endRow();
+    }
+    *this = b.finish();
+}
+
+RleMask RleMask::inverted() const {
+    Builder b(w_, h_);
+    for (int y = 0; y < h_; y++) {
+        int x = 0;
+        for (const Run* r = rowBegin(y); r != rowEnd(y); ++r) {
+            b.add(x, r->start);
+            x = r->end;
+        }
+        b.add(x, w_);
+        b.endRow();
+    }
+    return b.finish();
+}
+
+// --- morphology ---------------------------------------------------
+
+RleMask RleMask::dilated(int kw, int kh) const {
+    return dilateImpl(kw, kh, kw / 2, kh / 2);
+}
+
+// Erosion is the complement of dilating the complement; the inverted
+// image has no set pixels outside, which gives erode's "outside is
+// set" border for free.
+RleMask RleMask::eroded(int kw, int kh) const {
+    return inverted().dilateImpl(kw, kh, kw / 2, kh / 2).inverted();
+}
+
+RleMask RleMask::closed(int kw, int kh, int iterations) const {
+    int KW = (kw - 1) * iterations + 1, KH = (kh - 1) * iterations + 1;
+    int ax = (kw / 2) * iterations, ay = (kh / 2) * iterations;
+    return dilateImpl(KW, KH, ax, ay)
+          .inverted().dilateImpl(KW, KH, ax, ay).inverted();
+}
+
+RleMask RleMask::opened(int kw, int kh, int iterations) const {
+    int KW = (kw - 1) * iterations + 1, KH = (kh - 1) * iterations + 1;
+    int ax = (kw / 2) * iterations, ay = (kh / 2) * iterations;
+    return inverted().dilateImpl(KW, KH, ax, ay)
+          .inverted().dilateImpl(KW, KH, ax, ay);
+}
+
+// dst(x, y) = max src(x + i - ax, y + j - ay) over the kw x kh window,
+// with pixels outside the image treated as unset.
+RleMask RleMask::dilateImpl(int kw, int kh, int ax, int ay) const {
+    int left = kw - 1 - ax, right = ax;     // horizontal growth
+    int up = ay, down = kh - 1 - ay;        // source rows above / below
+
+    // Horizontal pass: widen every run, merge overlaps.
+    Builder horiz(w_, h_);
+    for (int y = 0; y < h_; y++) {
+        for (const Run* r = rowBegin(y); r != rowEnd(y); ++r)
+            horiz.add(std::max(0, r->start - left),
+                      std::min(w_, r->end + right));
+        horiz.endRow();
+    }
+    RleMask hm = horiz.finish();
+
+    // Vertical pass: each output row is the union of its source window.
+    Builder b(w_, h_);
+    std::vector<Run> window;
+    for (int y = 0; y < h_; y++) {
+        int y0 = std::max(0, y - up), y1 = std::min(h_ - 1, y + down);
+        window.assign(hm.rowBegin(y0), hm.rowEnd(y1));
+        if (y1 > y0)
+            std::sort(window.begin(), window.end(),
+                [](const Run& a, const Run& c) { return a.start < c.start; });
+        for (const Run& r : window) b.add(r.start, r.end);
+        b.endRow();
+    }
+    return b.finish();
+}
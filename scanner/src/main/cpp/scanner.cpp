@@ -19,464 +19,719 @@
 #include <jni.h>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
-#include <android/log.h>
+#include <android/bitmap.h>
+#include "detector.h"
+#include "flight_recorder.h"
+#include "frame_fusion.h"
+#include "ingest.h"
+#include "mat_pool.h"
+#include "memory_budget.h"
+#include "rectify.h"
+#include "scanner_log.h"
+#include "session.h"
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include <numeric>
-
-#define TAG "DocScanner"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
-
-// ===================================================================
-// Document scanner — edge-support scoring pipeline.
-//
-// Key insight: the BEST rectangle is NOT the biggest one.
-// It's the one whose 4 edges have the strongest, most consistent
-// gradient support in the original image.  A real document edge
-// shows a clear brightness/colour change; a false-positive
-// contour from thresholding artifacts does not.
-// ===================================================================
-
-// --- geometry helpers ---------------------------------------------
-
-static double angleCos(const cv::Point& p1, const cv::Point& p2,
-                       const cv::Point& p0) {
-    double dx1 = p1.x - p0.x, dy1 = p1.y - p0.y;
-    double dx2 = p2.x - p0.x, dy2 = p2.y - p0.y;
-    return (dx1 * dx2 + dy1 * dy2)
-         / std::sqrt((dx1*dx1 + dy1*dy1) * (dx2*dx2 + dy2*dy2) + 1e-10);
-}
-
-static void orderPoints(std::vector<cv::Point>& pts) {
-    std::vector<cv::Point> o(4);
-    std::vector<int> s(4), d(4);
-    for (int i = 0; i < 4; i++) {
-        s[i] = pts[i].x + pts[i].y;
-        d[i] = pts[i].y - pts[i].x;
+#include <memory>
+#include <string>
+
+// --- warm-up ------------------------------------------------------
+
+// Synthetic RGBA frame: textured desk, a slightly rotated light page
+// with a few dark "text" lines, so every strategy finds something to
+// trace and every code path down to candidate scoring is exercised.
+static cv::Mat syntheticFrame(int width, int height) {
+    cv::Mat frame(height, width, CV_8UC4);
+    cv::randn(frame, cv::Scalar(96, 84, 70, 255), cv::Scalar(12, 12, 12, 0));
+
+    cv::Point2f c(width * 0.5f, height * 0.5f);
+    cv::RotatedRect page(c, cv::Size2f(width * 0.6f, height * 0.7f), 7.f);
+    cv::Point2f v[4];
+    page.points(v);
+    std::vector<cv::Point> poly(v, v + 4);
+    cv::fillConvexPoly(frame, poly, cv::Scalar(235, 232, 225, 255),
+                       cv::LINE_AA);
+    for (int i = 1; i < 8; i++) {
+        float t = i / 8.f;
+        cv::Point2f a = v[1] + (v[0] - v[1]) * t, b = v[2] + (v[3] - v[2]) * t;
+        cv::line(frame, a + (b - a) * 0.15f, a + (b - a) * 0.85f,
+                 cv::Scalar(40, 40, 40, 255), std::max(1, height / 200));
     }
-    o[0] = pts[std::min_element(s.begin(), s.end()) - s.begin()];
-    o[2] = pts[std::max_element(s.begin(), s.end()) - s.begin()];
-    o[1] = pts[std::min_element(d.begin(), d.end()) - d.begin()];
-    o[3] = pts[std::max_element(d.begin(), d.end()) - d.begin()];
-    pts = o;
+    return frame;
 }
 
-// --- quad validation ---------------------------------------------
+// detectDocument() on the calling thread's Mat pool (bound by the
+// caller), with its memory measured into the budget model.
+static std::vector<cv::Point> detectMetered(
+        const cv::Mat& small, double scale, bool earlyReject,
+        PageOrientation* orientation = nullptr) {
+    DetectionMeter meter(threadMatPool());
+    std::vector<cv::Point> quad =
+        detectDocument(small, scale, earlyReject, orientation);
+    meter.record(small.size());
+    return quad;
+}
 
-struct Candidate {
-    std::vector<cv::Point> quad;
-    double area;
-    double edgeScore;   // average gradient magnitude along boundary
-};
+// Pays every one-time cost of the first detection up front: OpenCV's
+// worker pool, lazily built tables and kernels, this thread's CLAHE
+// and Mat pool, and the code pages of the whole pipeline.  The
+// detection also gives the memory budget its first measurement.
+static bool warmUp(int width, int height) {
+    cv::parallel_for_(cv::Range(0, std::max(1, cv::getNumThreads())),
+                      [](const cv::Range&) {});
+
+    ScopedMatPool pool(threadMatPool());
+    double scale;
+    cv::Mat small = ingestFrame(syntheticFrame(width, height), TARGET, scale);
+    bool found = !detectMetered(small, scale, true).empty();
+    LOGD("warmUp: %dx%d found=%d", width, height, found);
+    return found;
+}
 
-static bool isGoodQuad(const std::vector<cv::Point>& quad, double imgArea,
-                       int imgW, int imgH) {
-    double area = cv::contourArea(quad);
-    if (area < imgArea * 0.05 || area > imgArea * 0.85) return false;
-    if (!cv::isContourConvex(quad)) return false;
-
-    // Reject quads where 3+ corners sit on the image border
-    int borderMargin = 5;
-    int borderCount = 0;
-    for (auto& p : quad) {
-        if (p.x <= borderMargin || p.y <= borderMargin ||
-            p.x >= imgW - borderMargin - 1 || p.y >= imgH - borderMargin - 1)
-            borderCount++;
-    }
-    if (borderCount >= 3) return false;
+// ========== JNI ==================================================
 
-    double maxCos = 0;
-    for (int j = 2; j < 5; j++) {
-        double cos = std::fabs(angleCos(quad[j % 4], quad[j - 2], quad[j - 1]));
-        if (cos > maxCos) maxCos = cos;
-    }
-    return maxCos < 0.4;
+// Every detection entry point binds the calling thread's Mat pool, so
+// the working image, the per-strategy buffers and OpenCV's own
+// temporaries are recycled from the previous frame.
+
+// Orientation of the page last found by a still-image entry point on
+// this thread.
+static thread_local PageOrientation g_lastOrientation;
+
+// What the memory budget cost the last detection on this thread.
+static thread_local int g_lastDegradation = DEGRADED_NONE;
+
+// Detector working size for a `width` x `height` source already in
+// memory, within the memory budget; 0 when not even the smallest plan
+// fits, and the source must not be detected.
+static int workingSide(int width, int height) {
+    MemoryPlan plan = planCapture(width, height, 1);
+    g_lastDegradation = plan.degraded;
+    if (plan.fits) return plan.workingSide;
+    g_lastDegradation |= DEGRADED_OVER_BUDGET;
+    LOGD("memory: %dx%d does not fit the budget, not detected",
+         width, height);
+    return 0;
 }
 
-// Compute average gradient magnitude along the 4 edges of a quad.
-// Higher = stronger real edges in the image along this quad's boundary.
-static double computeEdgeScore(const std::vector<cv::Point>& quad,
-                               const cv::Mat& gradMag) {
-    double totalGrad = 0;
-    int numSamples = 0;
+static jfloatArray quadToJni(JNIEnv* env,
+                             const std::vector<cv::Point>& quad) {
+    if (quad.empty()) return nullptr;
+    jfloatArray result = env->NewFloatArray(8);
+    float pts[8];
     for (int i = 0; i < 4; i++) {
-        cv::Point p1 = quad[i], p2 = quad[(i + 1) % 4];
-        double edgeLen = cv::norm(p2 - p1);
-        int nSamples = std::max(10, (int)edgeLen);
-        for (int s = 0; s < nSamples; s++) {
-            float t = (float)s / nSamples;
-            int x = (int)(p1.x + t * (p2.x - p1.x));
-            int y = (int)(p1.y + t * (p2.y - p1.y));
-            if (x >= 0 && x < gradMag.cols && y >= 0 && y < gradMag.rows) {
-                totalGrad += gradMag.at<float>(y, x);
-                numSamples++;
-            }
-        }
-    }
-    return numSamples > 0 ? totalGrad / numSamples : 0;
-}
-
-// --- candidate collection ----------------------------------------
-
-// Extract quad candidates from a binary/edge image into the list.
-static void collectQuads(const cv::Mat& edges, double imgArea,
-                         const cv::Mat& gradMag,
-                         std::vector<Candidate>& candidates) {
-    // Zero out borders to prevent frame-spanning contours
-    cv::Mat clean = edges.clone();
-    int border = 5;
-    clean.rowRange(0, border).setTo(0);
-    clean.rowRange(clean.rows - border, clean.rows).setTo(0);
-    clean.colRange(0, border).setTo(0);
-    clean.colRange(clean.cols - border, clean.cols).setTo(0);
-
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(clean, contours, cv::RETR_EXTERNAL,
-                     cv::CHAIN_APPROX_SIMPLE);
-
-    // Sort by area descending, check only top candidates
-    std::sort(contours.begin(), contours.end(),
-        [](const auto& a, const auto& b) {
-            return cv::contourArea(a) > cv::contourArea(b);
-        });
-
-    int limit = std::min((int)contours.size(), 20);
-    for (double eps : {0.02, 0.04}) {
-        for (int i = 0; i < limit; i++) {
-            double peri = cv::arcLength(contours[i], true);
-            std::vector<cv::Point> approx;
-            cv::approxPolyDP(contours[i], approx, eps * peri, true);
-            if (approx.size() == 4 &&
-                isGoodQuad(approx, imgArea, clean.cols, clean.rows)) {
-                double area = cv::contourArea(approx);
-                double score = computeEdgeScore(approx, gradMag);
-                candidates.push_back({approx, area, score});
-            }
-        }
+        pts[i * 2]     = (float)quad[i].x;
+        pts[i * 2 + 1] = (float)quad[i].y;
     }
+    env->SetFloatArrayRegion(result, 0, 8, pts);
+    return result;
 }
 
-// --- detection strategies ----------------------------------------
+// Pins an ARGB_8888 Bitmap and exposes it as an RGBA cv::Mat header.
+class LockedBitmap {
+public:
+    LockedBitmap(JNIEnv* env, jobject bitmap) : env_(env), bitmap_(bitmap) {
+        AndroidBitmapInfo info;
+        void* pixels = nullptr;
+        if (AndroidBitmap_getInfo(env, bitmap, &info) !=
+                ANDROID_BITMAP_RESULT_SUCCESS ||
+            info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+            AndroidBitmap_lockPixels(env, bitmap, &pixels) !=
+                ANDROID_BITMAP_RESULT_SUCCESS)
+            return;
+        mat = cv::Mat((int)info.height, (int)info.width, CV_8UC4, pixels,
+                      info.stride);
+    }
+    ~LockedBitmap() {
+        if (!mat.empty()) AndroidBitmap_unlockPixels(env_, bitmap_);
+    }
+    LockedBitmap(const LockedBitmap&) = delete;
+    LockedBitmap& operator=(const LockedBitmap&) = delete;
 
-// Strategy 1: Per-channel Canny + binary thresholds (squares-demo)
-static void findSquaresMultiChannel(const cv::Mat& img, double imgArea,
-                                    const cv::Mat& gradMag,
-                                    std::vector<Candidate>& candidates) {
-    cv::Mat pyr, filtered;
-    cv::pyrDown(img, pyr, cv::Size(img.cols / 2, img.rows / 2));
-    cv::pyrUp(pyr, filtered, img.size());
+    cv::Mat mat;
 
-    cv::Mat gray0(filtered.size(), CV_8U);
-    for (int c = 0; c < filtered.channels(); c++) {
-        int ch[] = {c, 0};
-        cv::mixChannels(&filtered, 1, &gray0, 1, ch, 1);
+private:
+    JNIEnv* env_;
+    jobject bitmap_;
+};
 
-        // Canny pass
-        cv::Mat binary;
-        cv::Canny(gray0, binary, 20, 80, 3);
-        cv::dilate(binary, binary, cv::Mat(), cv::Point(-1, -1));
-        collectQuads(binary, imgArea, gradMag, candidates);
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_findDocumentCorners(
+        JNIEnv *env, jobject, jlong addr) {
+    ScopedMatPool pool(threadMatPool());
+    FrameTrace trace("preview");
+    cv::Mat& frame = *(cv::Mat*)addr;
+    double scale;
+    int side = workingSide(frame.cols, frame.rows);
+    if (!side) return nullptr;
+    cv::Mat small = ingestFrame(frame, side, scale);
+    FrameTrace::mark("ingest");
+    return quadToJni(env, detectMetered(small, scale, true));
+}
 
-        // Binary threshold passes
-        for (int l = 1; l <= 6; l++) {
-            binary = gray0 >= (l * 255 / 7);
-            collectQuads(binary, imgArea, gradMag, candidates);
-        }
-    }
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_findDocumentCornersColor(
+        JNIEnv *env, jobject, jlong addr) {
+    ScopedMatPool pool(threadMatPool());
+    FrameTrace trace("still");
+    cv::Mat& frame = *(cv::Mat*)addr;
+    double scale;
+    int side = workingSide(frame.cols, frame.rows);
+    if (!side) return nullptr;
+    cv::Mat small = ingestFrame(frame, side, scale);
+    FrameTrace::mark("ingest");
+    return quadToJni(env, detectMetered(small, scale, false,
+                                        &g_lastOrientation));
 }
 
-// Strategy 2: Morphological gradient
-static void findByMorphGradient(const cv::Mat& img, double imgArea,
-                                const cv::Mat& gradMag,
-                                std::vector<Candidate>& candidates) {
-    cv::Mat gray;
-    if (img.channels() >= 3)
-        cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
-    else
-        gray = img;
-
-    for (int kSize : {3, 5}) {
-        cv::Mat blurred;
-        cv::medianBlur(gray, blurred, 7);
-        cv::Mat elem = cv::getStructuringElement(cv::MORPH_RECT,
-                                                  cv::Size(kSize, kSize));
-        cv::Mat dilated, eroded, gradient;
-        cv::dilate(blurred, dilated, elem);
-        cv::erode(blurred, eroded, elem);
-        cv::subtract(dilated, eroded, gradient);
-
-        cv::Mat binary;
-        cv::threshold(gradient, binary, 0, 255,
-                      cv::THRESH_BINARY | cv::THRESH_OTSU);
-        cv::Mat closeElem = cv::getStructuringElement(cv::MORPH_RECT,
-                                                       cv::Size(3, 3));
-        cv::morphologyEx(binary, binary, cv::MORPH_CLOSE, closeElem,
-                         cv::Point(-1,-1), 2);
-        collectQuads(binary, imgArea, gradMag, candidates);
+// Captured still straight from its Bitmap: no Mat copy, no BGR copy
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_findDocumentCornersBitmap(
+        JNIEnv *env, jobject, jobject bitmap) {
+    ScopedMatPool pool(threadMatPool());
+    FrameTrace trace("bitmap");
+    double scale;
+    cv::Mat small;
+    {
+        LockedBitmap bmp(env, bitmap);
+        if (bmp.mat.empty()) return nullptr;
+        int side = workingSide(bmp.mat.cols, bmp.mat.rows);
+        if (!side) return nullptr;
+        small = ingestFrame(bmp.mat, side, scale);
     }
+    FrameTrace::mark("ingest");
+    return quadToJni(env, detectMetered(small, scale, false,
+                                        &g_lastOrientation));
 }
 
-// Strategy 3: HSV saturation (both directions)
-static void findBySaturation(const cv::Mat& bgr, double imgArea,
-                             const cv::Mat& gradMag,
-                             std::vector<Candidate>& candidates) {
-    cv::Mat hsv;
-    cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
-    std::vector<cv::Mat> ch;
-    cv::split(hsv, ch);
-
-    cv::Mat sat;
-    cv::GaussianBlur(ch[1], sat, cv::Size(7, 7), 0);
-
-    cv::Mat tInv, tNorm;
-    cv::threshold(sat, tInv, 0, 255,
-                  cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
-    cv::threshold(sat, tNorm, 0, 255,
-                  cv::THRESH_BINARY | cv::THRESH_OTSU);
-
-    cv::Mat kClose = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(9, 9));
-    for (auto& t : {tInv, tNorm}) {
-        cv::Mat cleaned;
-        cv::morphologyEx(t, cleaned, cv::MORPH_CLOSE, kClose,
-                         cv::Point(-1,-1), 3);
-        cv::morphologyEx(cleaned, cleaned, cv::MORPH_OPEN,
-            cv::getStructuringElement(cv::MORPH_RECT, cv::Size(5, 5)),
-            cv::Point(-1,-1), 1);
-        collectQuads(cleaned, imgArea, gradMag, candidates);
-    }
+// Strip-wise ingest of stills too large to hold decoded (the caller
+// decodes row bands, e.g. with BitmapRegionDecoder, and frees each).
+// Corners come back in the coordinates of the declared source size.
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_trudido_scanner_NativeScanner_ingestBegin(
+        JNIEnv *, jobject, jint width, jint height) {
+    if (width <= 0 || height <= 0) return 0;
+    // The source is never held whole, so this plan is conservative
+    int side = workingSide(width, height);
+    if (!side) return 0;
+    return (jlong)new StripIngest(width, height, side);
 }
 
-// Strategy 4: Background colour distance
-static void findByColorDistance(const cv::Mat& bgr, double imgArea,
-                                const cv::Mat& gradMag,
-                                std::vector<Candidate>& candidates) {
-    int h = bgr.rows, w = bgr.cols;
-    double bSum = 0, gSum = 0, rSum = 0;
-    int n = 0;
-    for (int x = 0; x < w; x += 2) {
-        auto p0 = bgr.at<cv::Vec3b>(0, x);
-        auto p1 = bgr.at<cv::Vec3b>(h - 1, x);
-        bSum += p0[0] + p1[0]; gSum += p0[1] + p1[1]; rSum += p0[2] + p1[2];
-        n += 2;
-    }
-    for (int y = 1; y < h - 1; y += 2) {
-        auto p0 = bgr.at<cv::Vec3b>(y, 0);
-        auto p1 = bgr.at<cv::Vec3b>(y, w - 1);
-        bSum += p0[0] + p1[0]; gSum += p0[1] + p1[1]; rSum += p0[2] + p1[2];
-        n += 2;
-    }
-    double bM = bSum / n, gM = gSum / n, rM = rSum / n;
-
-    cv::Mat dist(h, w, CV_32FC1);
-    for (int y = 0; y < h; y++) {
-        const auto* row = bgr.ptr<cv::Vec3b>(y);
-        auto* drow = dist.ptr<float>(y);
-        for (int x = 0; x < w; x++) {
-            double db = row[x][0] - bM, dg = row[x][1] - gM,
-                   dr = row[x][2] - rM;
-            drow[x] = (float)std::sqrt(db*db + dg*dg + dr*dr);
-        }
-    }
-    cv::Mat distU8;
-    cv::normalize(dist, distU8, 0, 255, cv::NORM_MINMAX);
-    distU8.convertTo(distU8, CV_8UC1);
-
-    cv::Mat binary;
-    cv::threshold(distU8, binary, 0, 255,
-                  cv::THRESH_BINARY | cv::THRESH_OTSU);
-    cv::Mat kClose = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(9, 9));
-    cv::morphologyEx(binary, binary, cv::MORPH_CLOSE, kClose,
-                     cv::Point(-1,-1), 3);
-    collectQuads(binary, imgArea, gradMag, candidates);
-}
-
-// Strategy 5: Lab L/a*/b* edges
-static void findByLabEdges(const cv::Mat& bgr, double imgArea,
-                           const cv::Mat& gradMag,
-                           std::vector<Candidate>& candidates) {
-    cv::Mat lab;
-    cv::cvtColor(bgr, lab, cv::COLOR_BGR2Lab);
-    std::vector<cv::Mat> ch;
-    cv::split(lab, ch);
-
-    for (int lo : {10, 25, 45}) {
-        cv::Mat l, a, b;
-        cv::GaussianBlur(ch[0], l, cv::Size(5, 5), 0);
-        cv::GaussianBlur(ch[1], a, cv::Size(5, 5), 0);
-        cv::GaussianBlur(ch[2], b, cv::Size(5, 5), 0);
-        cv::Mat eL, eA, eB, combined;
-        cv::Canny(l, eL, lo, lo * 3);
-        cv::Canny(a, eA, lo, lo * 3);
-        cv::Canny(b, eB, lo, lo * 3);
-        cv::bitwise_or(eA, eB, combined);
-        cv::bitwise_or(combined, eL, combined);
-        cv::dilate(combined, combined,
-            cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
-        collectQuads(combined, imgArea, gradMag, candidates);
-    }
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_trudido_scanner_NativeScanner_ingestPush(
+        JNIEnv *env, jobject, jlong handle, jobject strip) {
+    LockedBitmap bmp(env, strip);
+    if (!handle || bmp.mat.empty()) return JNI_FALSE;
+    ((StripIngest*)handle)->push(bmp.mat);
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_ingestFinish(
+        JNIEnv *env, jobject, jlong handle) {
+    if (!handle) return nullptr;
+    ScopedMatPool pool(threadMatPool());
+    FrameTrace trace("strips");
+    std::unique_ptr<StripIngest> ingest((StripIngest*)handle);
+    cv::Mat small = ingest->finish();
+    FrameTrace::mark("ingest");
+    return quadToJni(env, detectMetered(small, ingest->scale(), false));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_ingestCancel(
+        JNIEnv *, jobject, jlong handle) {
+    delete (StripIngest*)handle;
+}
+
+// Temporal live-preview mode: one detector per camera stream, fed
+// every analysed frame; each call costs about `budgetMs`.
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_trudido_scanner_NativeScanner_temporalCreate(
+        JNIEnv *, jobject, jfloat budgetMs) {
+    return (jlong)new TemporalDetector(budgetMs);
+}
+
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_temporalDetect(
+        JNIEnv *env, jobject, jlong handle, jlong addr) {
+    if (!handle) return nullptr;
+    ScopedMatPool pool(threadMatPool());
+    FrameTrace trace("temporal");
+    cv::Mat& frame = *(cv::Mat*)addr;
+    double scale;
+    int side = workingSide(frame.cols, frame.rows);
+    if (!side) return nullptr;
+    cv::Mat small = ingestFrame(frame, side, scale);
+    FrameTrace::mark("ingest");
+    DetectionMeter meter(threadMatPool());
+    std::vector<cv::Point> quad =
+        ((TemporalDetector*)handle)->detect(small, scale);
+    meter.record(small.size());
+    return quadToJni(env, quad);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_temporalReset(
+        JNIEnv *, jobject, jlong handle) {
+    if (handle) ((TemporalDetector*)handle)->reset();
 }
 
-// Strategy 6: CLAHE-enhanced Canny
-static void findByCLAHECanny(const cv::Mat& bgr, double imgArea,
-                             const cv::Mat& gradMag,
-                             std::vector<Candidate>& candidates) {
-    cv::Mat gray;
-    if (bgr.channels() >= 3)
-        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
-    else
-        gray = bgr;
-
-    auto clahe = cv::createCLAHE(3.0, cv::Size(8, 8));
-    cv::Mat enhanced;
-    clahe->apply(gray, enhanced);
-
-    for (int lo : {20, 40, 70}) {
-        cv::Mat blurred, edges;
-        cv::GaussianBlur(enhanced, blurred, cv::Size(5, 5), 0);
-        cv::Canny(blurred, edges, lo, lo * 2.5);
-        cv::dilate(edges, edges,
-            cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5)));
-        collectQuads(edges, imgArea, gradMag, candidates);
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_temporalRelease(
+        JNIEnv *, jobject, jlong handle) {
+    delete (TemporalDetector*)handle;
+}
+
+// Off: every Canny strategy sweeps its fixed thresholds each frame.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_setAdaptiveCanny(
+        JNIEnv *, jobject, jboolean enabled) {
+    setAdaptiveCanny(enabled == JNI_TRUE);
+}
+
+// Run once on a background thread while the camera opens.  When run
+// on the thread that will detect, its buffer pool starts out warm too.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_trudido_scanner_NativeScanner_warmUp(
+        JNIEnv *, jobject, jint width, jint height) {
+    if (width <= 0 || height <= 0) return JNI_FALSE;
+    return warmUp(width, height) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_lastRejectReason(
+        JNIEnv *, jobject) {
+    return lastRejectReason();
+}
+
+// {degrees, confidence} for the last still detected on this thread.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_trudido_scanner_NativeScanner_lastOrientation(
+        JNIEnv *env, jobject) {
+    float v[2] = {(float)g_lastOrientation.degrees,
+                  g_lastOrientation.confidence};
+    jfloatArray result = env->NewFloatArray(2);
+    env->SetFloatArrayRegion(result, 0, 2, v);
+    return result;
+}
+
+// DEGRADED_* flags of the last detection on this thread.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_lastDegradation(
+        JNIEnv *, jobject) {
+    return g_lastDegradation;
+}
+
+// 0 lifts the budget.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_setMemoryBudget(
+        JNIEnv *, jobject, jlong bytes) {
+    setMemoryBudget(bytes > 0 ? (size_t)bytes : 0);
+}
+
+// {sample, workingSide, pagePixels, peakBytes, degraded, fits} for a
+// still of width x height.
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_trudido_scanner_NativeScanner_memoryPlan(
+        JNIEnv *env, jobject, jint width, jint height) {
+    if (width <= 0 || height <= 0) return nullptr;
+    MemoryPlan plan = planCapture(width, height);
+    jlong v[6] = {plan.sample, plan.workingSide, plan.pagePixels,
+                  plan.peakBytes, plan.degraded, plan.fits ? 1 : 0};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, v);
+    return result;
+}
+
+// Slow-frame recorder: snapshots of detections slower than
+// `thresholdMs` go to `dir` (null keeps the in-memory ring only).
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_flightRecorderConfigure(
+        JNIEnv *env, jobject, jstring dir, jfloat thresholdMs) {
+    std::string path;
+    if (dir) {
+        const char* chars = env->GetStringUTFChars(dir, nullptr);
+        path = chars;
+        env->ReleaseStringUTFChars(dir, chars);
     }
+    configureFlightRecorder(path, thresholdMs);
 }
 
-// --- main pipeline ------------------------------------------------
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_trudido_scanner_NativeScanner_flightRecorderDump(
+        JNIEnv *env, jobject) {
+    return env->NewStringUTF(dumpFlightRecorder().c_str());
+}
 
-static std::vector<cv::Point> detectDocument(const cv::Mat& bgr) {
-    // Resize to workable resolution
-    cv::Mat small;
-    double scale = 1.0;
-    const int TARGET = 600;
-    if (std::max(bgr.rows, bgr.cols) > TARGET) {
-        scale = (double)TARGET / std::max(bgr.rows, bgr.cols);
-        cv::resize(bgr, small, cv::Size(), scale, scale, cv::INTER_AREA);
-    } else {
-        small = bgr.clone();
+// {hits, misses, cachedBytes, liveBlocks, liveBytes, peakBytes} summed
+// over all Mat pools.
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_trudido_scanner_NativeScanner_matPoolStats(
+        JNIEnv *env, jobject) {
+    MatPoolStats ps = PooledMatAllocator::globalStats();
+    jlong v[6] = {ps.hits, ps.misses, ps.cachedBytes, ps.liveBlocks,
+                  ps.liveBytes, ps.peakBytes};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, v);
+    return result;
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_trudido_scanner_NativeScanner_rectify(
+        JNIEnv *env, jobject, jobject srcBitmap, jfloatArray corners,
+        jobject dstBitmap, jobjectArray downsampledBitmaps, jint enhanceMode,
+        jint rotation) {
+    if (rotation % 90 != 0 || !isEnhanceMode(enhanceMode)) return JNI_FALSE;
+    if (env->GetArrayLength(corners) != 8) return JNI_FALSE;
+    float c[8];
+    env->GetFloatArrayRegion(corners, 0, 8, c);
+    cv::Point2f quad[4];
+    for (int i = 0; i < 4; i++) quad[i] = {c[i * 2], c[i * 2 + 1]};
+
+    LockedBitmap src(env, srcBitmap), dst(env, dstBitmap);
+    if (src.mat.empty() || dst.mat.empty()) return JNI_FALSE;
+
+    int n = env->GetArrayLength(downsampledBitmaps);
+    std::vector<std::unique_ptr<LockedBitmap>> locked;
+    std::vector<cv::Mat> downsampled;
+    for (int i = 0; i < n; i++) {
+        jobject bmp = env->GetObjectArrayElement(downsampledBitmaps, i);
+        locked.emplace_back(new LockedBitmap(env, bmp));
+        const cv::Mat& m = locked.back()->mat;
+        if (m.empty() || m.cols > dst.mat.cols || m.rows > dst.mat.rows)
+            return JNI_FALSE;
+        downsampled.push_back(m);
     }
-    double imgArea = small.rows * small.cols;
+    return rectifyFused(src.mat, quad, (EnhanceMode)enhanceMode, dst.mat,
+                        downsampled, rotation) ? JNI_TRUE : JNI_FALSE;
+}
 
-    LOGD("detectDocument: input=%dx%d small=%dx%d scale=%.4f",
-         bgr.cols, bgr.rows, small.cols, small.rows, scale);
+// Live preview while dragging crop corners: the source bitmap is
+// downsampled once at create, each render repaints only the tiles of
+// `dstBitmap` whose source footprint moved.
 
-    // Pre-compute gradient magnitude map (used to score ALL candidates)
-    cv::Mat gray;
-    cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
-    cv::Mat gradX, gradY, gradMag;
-    cv::Sobel(gray, gradX, CV_32F, 1, 0);
-    cv::Sobel(gray, gradY, CV_32F, 0, 1);
-    cv::magnitude(gradX, gradY, gradMag);
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_trudido_scanner_NativeScanner_previewCreate(
+        JNIEnv *env, jobject, jobject srcBitmap, jint maxSide) {
+    LockedBitmap src(env, srcBitmap);
+    if (src.mat.empty() || maxSide <= 0) return 0;
+    return (jlong)new PreviewRectifier(src.mat, maxSide);
+}
 
-    // Collect ALL valid quad candidates from all strategies
-    std::vector<Candidate> candidates;
+// Returns the number of tiles repainted, or -1 on bad arguments.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_previewRender(
+        JNIEnv *env, jobject, jlong handle, jfloatArray corners,
+        jobject dstBitmap) {
+    if (!handle || env->GetArrayLength(corners) != 8) return -1;
+    float c[8];
+    env->GetFloatArrayRegion(corners, 0, 8, c);
+    cv::Point2f quad[4];
+    for (int i = 0; i < 4; i++) quad[i] = {c[i * 2], c[i * 2 + 1]};
+
+    LockedBitmap dst(env, dstBitmap);
+    if (dst.mat.empty()) return -1;
+    return ((PreviewRectifier*)handle)->render(quad, dst.mat);
+}
 
-    findSquaresMultiChannel(small, imgArea, gradMag, candidates);
-    LOGD("  after multiChannel: %d candidates", (int)candidates.size());
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_previewRelease(
+        JNIEnv *, jobject, jlong handle) {
+    delete (PreviewRectifier*)handle;
+}
 
-    findByMorphGradient(small, imgArea, gradMag, candidates);
-    LOGD("  after morphGradient: %d candidates", (int)candidates.size());
+// Multi-frame fused capture: preview frames are pushed with the quad
+// tracked in them, render merges the aligned frames into one page.
 
-    findBySaturation(small, imgArea, gradMag, candidates);
-    LOGD("  after saturation: %d candidates", (int)candidates.size());
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_trudido_scanner_NativeScanner_fusionCreate(
+        JNIEnv *, jobject, jint capacity) {
+    if (capacity <= 0) return 0;
+    return (jlong)new FrameFusion(capacity);
+}
 
-    findByColorDistance(small, imgArea, gradMag, candidates);
-    LOGD("  after colorDist: %d candidates", (int)candidates.size());
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_fusionPush(
+        JNIEnv *env, jobject, jlong handle, jlong addr, jfloatArray corners) {
+    if (!handle || !corners || env->GetArrayLength(corners) != 8) return;
+    float c[8];
+    env->GetFloatArrayRegion(corners, 0, 8, c);
+    std::vector<cv::Point> quad;
+    for (int i = 0; i < 4; i++)
+        quad.emplace_back((int)std::lround(c[i * 2]),
+                          (int)std::lround(c[i * 2 + 1]));
+    ((FrameFusion*)handle)->push(*(cv::Mat*)addr, quad);
+}
+
+// Returns the number of frames merged; 0 leaves `dstBitmap` untouched.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_fusionRender(
+        JNIEnv *env, jobject, jlong handle, jobject dstBitmap,
+        jint enhanceMode, jint rotation) {
+    if (!handle || rotation % 90 != 0 || !isEnhanceMode(enhanceMode))
+        return 0;
+    ScopedMatPool pool(threadMatPool());
+    LockedBitmap dst(env, dstBitmap);
+    if (dst.mat.empty()) return 0;
+    return ((FrameFusion*)handle)->render((EnhanceMode)enhanceMode, dst.mat,
+                                          rotation);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_fusionReset(
+        JNIEnv *, jobject, jlong handle) {
+    if (handle) ((FrameFusion*)handle)->reset();
+}
 
-    findByLabEdges(small, imgArea, gradMag, candidates);
-    LOGD("  after labEdges: %d candidates", (int)candidates.size());
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_fusionRelease(
+        JNIEnv *, jobject, jlong handle) {
+    delete (FrameFusion*)handle;
+}
 
-    findByCLAHECanny(small, imgArea, gradMag, candidates);
-    LOGD("  after claheCanny: %d total candidates", (int)candidates.size());
+// Multi-page session: pages run through detect -> rectify -> deliver on
+// native threads; outputs are ARGB_8888 bitmaps handed to the Kotlin
+// listener, which encodes and appends them.
 
-    if (candidates.empty()) {
-        LOGD("  RESULT: no candidates found");
-        return {};
+static JNIEnv* currentEnv(JavaVM* vm) {
+    JNIEnv* env = nullptr;
+    vm->GetEnv((void**)&env, JNI_VERSION_1_6);
+    return env;
+}
+
+// Locked bitmap that may be released on any attached thread
+class SharedBitmap {
+public:
+    SharedBitmap(JavaVM* vm, JNIEnv* env, jobject bitmap) : vm_(vm) {
+        AndroidBitmapInfo info;
+        void* pixels = nullptr;
+        if (!bitmap ||
+            AndroidBitmap_getInfo(env, bitmap, &info) !=
+                ANDROID_BITMAP_RESULT_SUCCESS ||
+            info.format != ANDROID_BITMAP_FORMAT_RGBA_8888 ||
+            AndroidBitmap_lockPixels(env, bitmap, &pixels) !=
+                ANDROID_BITMAP_RESULT_SUCCESS)
+            return;
+        ref_ = env->NewGlobalRef(bitmap);
+        mat = cv::Mat((int)info.height, (int)info.width, CV_8UC4, pixels,
+                      info.stride);
+    }
+    ~SharedBitmap() {
+        if (!ref_) return;
+        JNIEnv* env = currentEnv(vm_);
+        AndroidBitmap_unlockPixels(env, ref_);
+        env->DeleteGlobalRef(ref_);
     }
+    SharedBitmap(const SharedBitmap&) = delete;
+    SharedBitmap& operator=(const SharedBitmap&) = delete;
+
+    jobject ref() const { return ref_; }
+    cv::Mat mat;
 
-    // Combined score = edgeScore * areaRatio
-    // Linear area weight strongly favours bigger quads while still
-    // letting edge quality break ties between similar-sized candidates.
-    //  - Tiny text quad (7% area, edge 260):  260 * 0.07 = 18
-    //  - Real document  (40% area, edge 60):   60 * 0.40 = 24  ← wins!
-    //  - Big false pos  (80% area, edge 30):   30 * 0.80 = 24
-    for (auto& c : candidates) {
-        double areaRatio = c.area / imgArea;
-        c.edgeScore = c.edgeScore * areaRatio;
+private:
+    JavaVM* vm_;
+    jobject ref_ = nullptr;
+};
+
+class JniSession {
+public:
+    JniSession(JNIEnv* env, jobject listener, EnhanceMode mode,
+               int thumbnailSide, int depth, bool autoRotate) {
+        env->GetJavaVM(&vm_);
+        listener_ = env->NewGlobalRef(listener);
+        jclass cls = env->GetObjectClass(listener);
+        onProgress_ = env->GetMethodID(cls, "onProgress", "(II)V");
+        onPage_ = env->GetMethodID(cls, "onPage",
+            "(ILandroid/graphics/Bitmap;Landroid/graphics/Bitmap;[F)V");
+        // Classes must be resolved here: FindClass on a native thread
+        // only sees the system class loader
+        jclass bmp = env->FindClass("android/graphics/Bitmap");
+        bitmapClass_ = (jclass)env->NewGlobalRef(bmp);
+        createBitmap_ = env->GetStaticMethodID(bmp, "createBitmap",
+            "(IILandroid/graphics/Bitmap$Config;)Landroid/graphics/Bitmap;");
+        jclass cfg = env->FindClass("android/graphics/Bitmap$Config");
+        argb8888_ = env->NewGlobalRef(env->GetStaticObjectField(cfg,
+            env->GetStaticFieldID(cfg, "ARGB_8888",
+                                  "Landroid/graphics/Bitmap$Config;")));
+
+        ScanSession::Hooks hooks;
+        hooks.threadStart = [this] {
+            JNIEnv* e;
+            vm_->AttachCurrentThreadAsDaemon(&e, nullptr);
+        };
+        hooks.threadStop = [this] { vm_->DetachCurrentThread(); };
+        hooks.progress = [this](int index, SessionStage stage) {
+            JNIEnv* e = currentEnv(vm_);
+            e->CallVoidMethod(listener_, onProgress_, index, (jint)stage);
+            clearException(e);
+        };
+        hooks.allocate = [this](ScanSession::Page& p, cv::Size pageSize,
+                                cv::Size thumbSize) {
+            auto out = std::make_shared<std::pair<
+                std::unique_ptr<SharedBitmap>, std::unique_ptr<SharedBitmap>>>(
+                newBitmap(pageSize), newBitmap(thumbSize));
+            if (!out->first || !out->second) return false;
+            p.page = out->first->mat;
+            p.thumbnail = out->second->mat;
+            p.outputOwner = out;
+            return true;
+        };
+        hooks.deliver = [this](ScanSession::Page& p) {
+            JNIEnv* e = currentEnv(vm_);
+            auto* out = (std::pair<std::unique_ptr<SharedBitmap>,
+                                   std::unique_ptr<SharedBitmap>>*)
+                            p.outputOwner.get();
+            float c[8];
+            for (int i = 0; i < 4; i++) {
+                c[i * 2] = (float)p.corners[i].x;
+                c[i * 2 + 1] = (float)p.corners[i].y;
+            }
+            // Java may touch the pixels now
+            p.page.release();
+            p.thumbnail.release();
+            jfloatArray corners = e->NewFloatArray(8);
+            e->SetFloatArrayRegion(corners, 0, 8, c);
+            e->CallVoidMethod(listener_, onPage_, p.index,
+                              out->first->ref(), out->second->ref(), corners);
+            clearException(e);
+            e->DeleteLocalRef(corners);
+        };
+        session_.reset(new ScanSession(std::move(hooks), mode, thumbnailSide,
+                                       (size_t)depth, autoRotate));
     }
 
-    auto& best = *std::max_element(candidates.begin(), candidates.end(),
-        [](const Candidate& a, const Candidate& b) {
-            return a.edgeScore < b.edgeScore;
-        });
-
-    LOGD("  BEST: combinedScore=%.1f area=%.0f (%.1f%%) corners=[%d,%d][%d,%d][%d,%d][%d,%d]",
-         best.edgeScore, best.area, best.area / imgArea * 100,
-         best.quad[0].x, best.quad[0].y, best.quad[1].x, best.quad[1].y,
-         best.quad[2].x, best.quad[2].y, best.quad[3].x, best.quad[3].y);
-
-    // Log top-5 candidates for debugging
-    std::sort(candidates.begin(), candidates.end(),
-        [](const Candidate& a, const Candidate& b) {
-            return a.edgeScore > b.edgeScore;
-        });
-    int logN = std::min(5, (int)candidates.size());
-    for (int i = 0; i < logN; i++) {
-        auto& c = candidates[i];
-        LOGD("  top%d: combined=%.1f area=%.1f%%", i+1,
-             c.edgeScore, c.area / imgArea * 100);
+    ~JniSession() {
+        session_.reset();
+        JNIEnv* env = currentEnv(vm_);
+        env->DeleteGlobalRef(listener_);
+        env->DeleteGlobalRef(bitmapClass_);
+        env->DeleteGlobalRef(argb8888_);
     }
 
-    // Scale back to original coordinates
-    auto result = best.quad;
-    for (auto& pt : result) {
-        pt.x = (int)std::round(pt.x / scale);
-        pt.y = (int)std::round(pt.y / scale);
+    int submit(JNIEnv* env, jobject bitmap, jfloatArray corners, bool wait) {
+        std::unique_ptr<ScanSession::Page> page(new ScanSession::Page);
+        auto src = std::make_shared<SharedBitmap>(vm_, env, bitmap);
+        if (src->mat.empty()) return -1;
+        page->source = src->mat;
+        page->sourceOwner = src;
+        if (corners && env->GetArrayLength(corners) == 8) {
+            float c[8];
+            env->GetFloatArrayRegion(corners, 0, 8, c);
+            for (int i = 0; i < 4; i++)
+                page->corners.emplace_back((int)std::lround(c[i * 2]),
+                                           (int)std::lround(c[i * 2 + 1]));
+        }
+        return session_->submit(std::move(page), wait);
     }
-    orderPoints(result);
-    return result;
-}
 
-// ========== JNI ==================================================
+    void finish() { session_->finish(); }
+    int degraded() const { return session_->degraded(); }
 
-static jfloatArray quadToJni(JNIEnv* env,
-                             const std::vector<cv::Point>& quad) {
-    if (quad.empty()) return nullptr;
-    jfloatArray result = env->NewFloatArray(8);
-    float pts[8];
-    for (int i = 0; i < 4; i++) {
-        pts[i * 2]     = (float)quad[i].x;
-        pts[i * 2 + 1] = (float)quad[i].y;
+private:
+    static void clearException(JNIEnv* env) {
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
     }
-    env->SetFloatArrayRegion(result, 0, 8, pts);
-    return result;
+
+    std::unique_ptr<SharedBitmap> newBitmap(cv::Size size) {
+        JNIEnv* env = currentEnv(vm_);
+        jobject bmp = env->CallStaticObjectMethod(bitmapClass_, createBitmap_,
+            size.width, size.height, argb8888_);
+        clearException(env);   // OutOfMemoryError fails the page
+        if (!bmp) return nullptr;
+        std::unique_ptr<SharedBitmap> shared(new SharedBitmap(vm_, env, bmp));
+        env->DeleteLocalRef(bmp);
+        if (shared->mat.empty()) return nullptr;
+        return shared;
+    }
+
+    JavaVM* vm_ = nullptr;
+    jobject listener_;
+    jmethodID onProgress_, onPage_;
+    jclass bitmapClass_;
+    jmethodID createBitmap_;
+    jobject argb8888_;
+    std::unique_ptr<ScanSession> session_;
+};
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_trudido_scanner_NativeScanner_sessionCreate(
+        JNIEnv *env, jobject, jobject listener, jint enhanceMode,
+        jint thumbnailSize, jint queueDepth, jboolean autoRotate) {
+    if (!listener || thumbnailSize <= 0 || queueDepth <= 0 ||
+        !isEnhanceMode(enhanceMode))
+        return 0;
+    return (jlong)new JniSession(env, listener, (EnhanceMode)enhanceMode,
+                                 thumbnailSize, queueDepth,
+                                 autoRotate == JNI_TRUE);
 }
 
+// Returns the page index, or -1 when the session is finished, the
+// bitmap is not ARGB_8888, or (wait = false) the pipeline is full.
 extern "C"
-JNIEXPORT jfloatArray JNICALL
-Java_com_trudido_scanner_NativeScanner_findDocumentCorners(
-        JNIEnv *env, jobject, jlong addr) {
-    cv::Mat& frame = *(cv::Mat*)addr;
-    cv::Mat bgr;
-    if (frame.channels() == 4)
-        cv::cvtColor(frame, bgr, cv::COLOR_RGBA2BGR);
-    else if (frame.channels() == 3)
-        bgr = frame;
-    else
-        cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
-    return quadToJni(env, detectDocument(bgr));
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_sessionSubmit(
+        JNIEnv *env, jobject, jlong handle, jobject bitmap,
+        jfloatArray corners, jboolean wait) {
+    if (!handle) return -1;
+    return ((JniSession*)handle)->submit(env, bitmap, corners,
+                                         wait == JNI_TRUE);
 }
 
 extern "C"
-JNIEXPORT jfloatArray JNICALL
-Java_com_trudido_scanner_NativeScanner_findDocumentCornersColor(
-        JNIEnv *env, jobject, jlong addr) {
-    cv::Mat& frame = *(cv::Mat*)addr;
-    cv::Mat bgr;
-    if (frame.channels() == 4)
-        cv::cvtColor(frame, bgr, cv::COLOR_RGBA2BGR);
-    else if (frame.channels() == 3)
-        bgr = frame;
-    else
-        cv::cvtColor(frame, bgr, cv::COLOR_GRAY2BGR);
-    return quadToJni(env, detectDocument(bgr));
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_sessionFinish(
+        JNIEnv *, jobject, jlong handle) {
+    if (handle) ((JniSession*)handle)->finish();
+}
+
+// DEGRADED_* flags of the session's pages so far.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_trudido_scanner_NativeScanner_sessionDegradation(
+        JNIEnv *, jobject, jlong handle) {
+    return handle ? ((JniSession*)handle)->degraded() : 0;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_trudido_scanner_NativeScanner_sessionRelease(
+        JNIEnv *, jobject, jlong handle) {
+    delete (JniSession*)handle;
 }
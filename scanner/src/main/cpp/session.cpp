@@ -0,0 +1,220 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "session.h"
+#include "detector.h"
+#include "flight_recorder.h"
+#include "ingest.h"
+#include "mat_pool.h"
+#include "memory_budget.h"
+#include "scanner_log.h"
+
+#include <algorithm>
+#include <cmath>
+
+ScanSession::ScanSession(Hooks hooks, EnhanceMode mode, int thumbnailSide,
+                         size_t depth, bool autoRotate)
+    : hooks_(std::move(hooks)), mode_(mode), thumbnailSide_(thumbnailSide),
+      autoRotate_(autoRotate),
+      toDetect_(depth), toRectify_(depth), toDeliver_(depth) {
+    if (size_t budget = memoryBudget()) {
+        // Detection scratch and the workers' pool caches are held once
+        long long fixed = detectionBytes(TARGET, TARGET) +
+                          unpooledDetectionBytes(TARGET, TARGET) +
+                          3 * (long long)poolCacheBytes();
+        limit_ = std::max(1LL, (long long)budget - fixed);
+    }
+    workers_.emplace_back(&ScanSession::runWorker, this,
+                          &ScanSession::detectLoop);
+    workers_.emplace_back(&ScanSession::runWorker, this,
+                          &ScanSession::rectifyLoop);
+    workers_.emplace_back(&ScanSession::runWorker, this,
+                          &ScanSession::deliverLoop);
+}
+
+ScanSession::~ScanSession() {
+    finish();
+}
+
+int ScanSession::submit(std::unique_ptr<Page> page, bool wait) {
+    // One submitter at a time keeps indices in queue order
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    if (finished_) return -1;
+    int index = nextIndex_;
+    page->index = index;
+    // The source, and a page of as many RGBA pixels
+    long long cost = limit_ ? (long long)page->source.total() *
+                              (page->source.elemSize() + 4) : 0;
+    if (!reserve(cost, wait)) return -1;
+    page->cost = cost;
+    if (!toDetect_.push(std::move(page), wait)) {
+        release(cost);
+        return -1;
+    }
+    nextIndex_++;
+    if (hooks_.progress) hooks_.progress(index, SESSION_QUEUED);
+    return index;
+}
+
+void ScanSession::finish() {
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+        if (finished_) return;
+        finished_ = true;
+    }
+    // Each stage closes the next queue once its input is drained
+    toDetect_.close();
+    for (auto& t : workers_) t.join();
+}
+
+void ScanSession::runWorker(void (ScanSession::*loop)()) {
+    if (hooks_.threadStart) hooks_.threadStart();
+    {
+        // Stage buffers are recycled from page to page
+        ScopedMatPool pool(threadMatPool());
+        (this->*loop)();
+    }
+    if (hooks_.threadStop) hooks_.threadStop();
+}
+
+void ScanSession::fail(PagePtr& page) {
+    LOGD("session: page %d failed", page->index);
+    int index = page->index;
+    long long cost = page->cost;
+    page.reset();
+    release(cost);
+    if (hooks_.progress) hooks_.progress(index, SESSION_FAILED);
+}
+
+bool ScanSession::reserve(long long bytes, bool wait) {
+    if (!bytes) return true;
+    std::unique_lock<std::mutex> lock(budgetMutex_);
+    auto fits = [&] { return inFlight_ == 0 || inFlight_ + bytes <= limit_; };
+    if (!fits()) {
+        if (!wait) return false;
+        degraded_ |= DEGRADED_PIPELINE;
+        budgetFreed_.wait(lock, fits);
+    }
+    inFlight_ += bytes;
+    return true;
+}
+
+void ScanSession::release(long long bytes) {
+    if (!bytes) return;
+    std::lock_guard<std::mutex> lock(budgetMutex_);
+    inFlight_ -= bytes;
+    budgetFreed_.notify_all();
+}
+
+// --- stages -------------------------------------------------------
+
+void ScanSession::detectLoop() {
+    PagePtr page;
+    while (toDetect_.pop(page)) {
+        PageOrientation orientation;
+        MemoryPlan plan = planCapture(page->source.cols, page->source.rows, 1);
+        if (!plan.fits) {
+            degraded_ |= DEGRADED_OVER_BUDGET;
+            fail(page);
+            continue;
+        }
+        if (page->corners.size() != 4) {
+            FrameTrace trace("session");
+            double scale;
+            cv::Mat small = ingestFrame(page->source, plan.workingSide, scale);
+            FrameTrace::mark("ingest");
+            DetectionMeter meter(threadMatPool());
+            page->corners = detectDocument(small, scale, false,
+                                           autoRotate_ ? &orientation : nullptr);
+            meter.record(small.size());
+        } else if (autoRotate_) {
+            double scale;
+            cv::Mat small = ingestFrame(page->source, plan.workingSide, scale);
+            orientation = estimatePageOrientation(small, scale, page->corners);
+        }
+        if (page->corners.size() != 4) {
+            fail(page);
+            continue;
+        }
+        degraded_ |= plan.degraded;
+        if (orientation.confidence >= ORIENTATION_MIN_CONFIDENCE)
+            page->rotation = orientation.degrees;
+        if (hooks_.progress) hooks_.progress(page->index, SESSION_DETECTED);
+        toRectify_.push(std::move(page));
+    }
+    toRectify_.close();
+}
+
+void ScanSession::rectifyLoop() {
+    PagePtr page;
+    while (toRectify_.pop(page)) {
+        cv::Point2f quad[4];
+        for (int i = 0; i < 4; i++) quad[i] = page->corners[i];
+
+        // Output size follows the longer of each pair of opposite edges
+        auto edge = [&](int a, int b) {
+            return (double)cv::norm(quad[b] - quad[a]);
+        };
+        int w = (int)std::max(edge(0, 1), edge(3, 2));
+        int h = (int)std::max(edge(0, 3), edge(1, 2));
+        if (limit_) {
+            // No larger than the reserve submit() took for it
+            MemoryPlan plan =
+                planCapture(page->source.cols, page->source.rows, 1);
+            cv::Size fitted = fitPage(plan, cv::Size(w, h));
+            w = fitted.width;
+            h = fitted.height;
+            degraded_ |= plan.degraded & DEGRADED_PAGE;
+        }
+        if (page->rotation % 180 != 0) std::swap(w, h);
+        double s = std::min(1.0, (double)thumbnailSide_ / std::max(w, h));
+        cv::Size thumbSize(std::max(1, (int)(w * s)), std::max(1, (int)(h * s)));
+        if (w < 2 || h < 2 ||
+            !hooks_.allocate(*page, cv::Size(w, h), thumbSize)) {
+            fail(page);
+            continue;
+        }
+
+        std::vector<cv::Mat> downsampled{page->thumbnail};
+        bool warped = rectifyFused(page->source, quad, mode_, page->page,
+                                   downsampled, page->rotation);
+        page->source.release();
+        page->sourceOwner.reset();
+        if (!warped) {
+            // Caller-supplied corners no homography maps onto
+            fail(page);
+            continue;
+        }
+
+        if (hooks_.progress) hooks_.progress(page->index, SESSION_RECTIFIED);
+        toDeliver_.push(std::move(page));
+    }
+    toDeliver_.close();
+}
+
+void ScanSession::deliverLoop() {
+    PagePtr page;
+    while (toDeliver_.pop(page)) {
+        if (hooks_.deliver) hooks_.deliver(*page);
+        int index = page->index;
+        long long cost = page->cost;
+        page.reset();
+        release(cost);
+        if (hooks_.progress) hooks_.progress(index, SESSION_DELIVERED);
+    }
+}
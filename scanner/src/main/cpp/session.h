@@ -0,0 +1,178 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "memory_budget.h"
+#include "rectify.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ===================================================================
+// Pipelined multi-page scanning.
+//
+// Each page passes three stages, each on its own thread and joined by
+// bounded queues:
+//
+//   detect   - strip ingest + full detection (skipped when the caller
+//              already has corners) and, if enabled, page orientation
+//   rectify  - fused warp + enhancement + rotation + thumbnail,
+//              straight into the buffers the `allocate` hook hands out
+//   deliver  - the `deliver` hook: encode and append (on Android the
+//              JPEG encoder lives on the Java side)
+//
+// A full queue blocks the stage feeding it, so a slow encoder throttles
+// rectification, which throttles detection, which throttles submit():
+// at most 3 * depth + 3 pages are ever in flight.  Page N + 1 can be
+// captured and detected while page N is still being rectified.
+//
+// Under a memory budget (memory_budget.h) submit() also holds each page
+// against it, source plus page reserve, until the page is delivered or
+// fails, so fewer pages overlap; one page alone is always admitted.
+// ===================================================================
+
+// Mirrored in NativeScanner.SESSION_*.
+enum SessionStage {
+    SESSION_QUEUED = 0,
+    SESSION_DETECTED = 1,
+    SESSION_RECTIFIED = 2,
+    SESSION_DELIVERED = 3,
+    SESSION_FAILED = 4,      // no document found or allocation refused
+};
+
+// Blocking FIFO with a fixed capacity.  pop() returns false once the
+// queue is closed and drained.
+template <class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+    bool push(T item, bool wait = true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!wait && items_.size() >= capacity_) return false;
+        notFull_.wait(lock, [&] {
+            return closed_ || items_.size() < capacity_;
+        });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable notEmpty_, notFull_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+class ScanSession {
+public:
+    struct Page {
+        int index = -1;
+        cv::Mat source;                   // as for rectifyFused()
+        std::vector<cv::Point> corners;   // preset skips detection
+        int rotation = 0;                 // clockwise, applied by rectify
+        long long cost = 0;               // bytes held against the budget
+        cv::Mat page, thumbnail;          // CV_8UC4, from `allocate`
+        // Released as soon as the stage using them is done: the source
+        // after rectification, the outputs after delivery.
+        std::shared_ptr<void> sourceOwner, outputOwner;
+    };
+
+    struct Hooks {
+        // Must set page.page (pageSize) and page.thumbnail (thumbSize)
+        // to CV_8UC4 buffers, and may set outputOwner.
+        std::function<bool(Page&, cv::Size pageSize, cv::Size thumbSize)>
+            allocate;
+        std::function<void(Page&)> deliver;
+        std::function<void(int index, SessionStage stage)> progress;
+        // Run on every worker thread before its first and after its
+        // last page (e.g. to attach to the JVM).
+        std::function<void()> threadStart, threadStop;
+    };
+
+    // `autoRotate` turns pages upright when their orientation is
+    // confidently detected; `rotation` is preserved otherwise.
+    ScanSession(Hooks hooks, EnhanceMode mode, int thumbnailSide,
+                size_t depth, bool autoRotate);
+    ~ScanSession();   // finish()
+
+    // Returns the page index, or -1 when the session is finished or,
+    // with `wait` false, when the first queue is full.
+    int submit(std::unique_ptr<Page> page, bool wait);
+
+    // Stops accepting pages and returns once every submitted page has
+    // been delivered or failed.
+    void finish();
+
+    // DEGRADED_* flags of every page so far.
+    int degraded() const { return degraded_; }
+
+private:
+    typedef std::unique_ptr<Page> PagePtr;
+
+    void detectLoop();
+    void rectifyLoop();
+    void deliverLoop();
+    void runWorker(void (ScanSession::*loop)());
+    void fail(PagePtr& page);
+    bool reserve(long long bytes, bool wait);
+    void release(long long bytes);
+
+    Hooks hooks_;
+    EnhanceMode mode_;
+    int thumbnailSide_;
+    bool autoRotate_;
+    BoundedQueue<PagePtr> toDetect_, toRectify_, toDeliver_;
+    std::vector<std::thread> workers_;
+    std::mutex submitMutex_;
+    int nextIndex_ = 0;
+    bool finished_ = false;
+
+    long long limit_ = 0;   // for pages in flight; 0 is unbounded
+    long long inFlight_ = 0;
+    std::mutex budgetMutex_;
+    std::condition_variable budgetFreed_;
+    std::atomic<int> degraded_{DEGRADED_NONE};
+};
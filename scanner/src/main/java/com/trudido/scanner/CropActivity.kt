@@ -18,34 +18,62 @@
 
 package com.trudido.scanner
 
+import android.content.Intent
+import android.graphics.Bitmap
 import android.graphics.BitmapFactory
 import android.graphics.Matrix
 import android.graphics.PointF
 import android.os.Bundle
 import android.util.Log
+import android.view.View
 import android.widget.Button
 import android.widget.ImageView
 import android.widget.Toast
 import androidx.appcompat.app.AppCompatActivity
 import org.opencv.android.OpenCVLoader
-import org.opencv.android.Utils
-import org.opencv.core.Mat
+import java.io.File
+import java.io.FileOutputStream
+import kotlin.math.hypot
+import kotlin.math.max
+import kotlin.math.sqrt
 
 /**
  * Shown after the user captures a photo in ScannerActivity.
  * Displays the still image with auto-detected corners that
- * the user can drag to adjust, then confirm.
+ * the user can drag to adjust, then confirm.  On confirm the
+ * page is rectified and its JPEG path returned as EXTRA_RESULT_PATH,
+ * together with a list thumbnail (EXTRA_THUMBNAIL_PATH) and the
+ * quality the memory budget cost (EXTRA_DEGRADED).
  */
 class CropActivity : AppCompatActivity() {
 
     companion object {
         const val EXTRA_IMAGE_PATH = "image_path"
+        const val EXTRA_RESULT_PATH = "result_path"
+        const val EXTRA_THUMBNAIL_PATH = "thumbnail_path"
+        // NativeScanner.DEGRADED_* flags: what the memory budget cost
+        const val EXTRA_DEGRADED = "degraded"
+        private const val THUMBNAIL_SIZE = 256
+        private const val PREVIEW_SOURCE_SIZE = 768   // downsampled source for the drag preview
+        private const val PREVIEW_SIZE = 320          // drag preview bitmap, longer side
         private const val TAG = "CropActivity"
     }
 
     private lateinit var cropOverlay: CropOverlayView
+    private lateinit var previewView: ImageView
     private val nativeScanner = NativeScanner()
 
+    // Native drag preview; created off the main thread after load
+    private var previewHandle = 0L
+    private var previewBitmap: Bitmap? = null
+
+    // Clockwise turn applied on confirm, from the orientation estimate
+    @Volatile private var pageRotation = 0
+
+    // Largest page the memory plan allows, and what it gave up so far
+    private var pagePixelLimit = Long.MAX_VALUE
+    @Volatile private var degraded = NativeScanner.DEGRADED_NONE
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         setContentView(R.layout.activity_crop)
@@ -54,6 +82,7 @@ class CropActivity : AppCompatActivity() {
 
         val imageView = findViewById<ImageView>(R.id.capturedImage)
         cropOverlay = findViewById(R.id.cropOverlay)
+        previewView = findViewById(R.id.rectifiedPreview)
 
         val imagePath = intent.getStringExtra(EXTRA_IMAGE_PATH)
         if (imagePath == null) {
@@ -62,8 +91,8 @@ class CropActivity : AppCompatActivity() {
             return
         }
 
-        // Load bitmap
-        val bitmap = BitmapFactory.decodeFile(imagePath)
+        // Load bitmap, subsampled if the memory budget requires it
+        val bitmap = decodeWithinBudget(imagePath)
         if (bitmap == null) {
             Toast.makeText(this, "Failed to load image", Toast.LENGTH_SHORT).show()
             finish()
@@ -106,16 +135,25 @@ class CropActivity : AppCompatActivity() {
 
             // Show default corners immediately while detection runs
             cropOverlay.setDefaultCorners()
+            cropOverlay.onCornerDrag = { corners -> updatePreview(bitmap, corners) }
 
             // Run detection off the main thread to avoid ANR
             Thread {
+                val handle = nativeScanner.previewCreate(bitmap, PREVIEW_SOURCE_SIZE)
+                runOnUiThread {
+                    if (isDestroyed) nativeScanner.previewRelease(handle)
+                    else previewHandle = handle
+                }
                 try {
-                    val mat = Mat()
-                    Utils.bitmapToMat(bitmap, mat)
-                    Log.d(TAG, "Mat created: ${mat.cols()}x${mat.rows()} ch=${mat.channels()}")
-                    val corners = nativeScanner.findDocumentCornersColor(mat.nativeObjAddr)
-                    mat.release()
+                    // Reads the bitmap in place; only the working image is allocated
+                    val corners = nativeScanner.findDocumentCornersBitmap(bitmap)
+                    degraded = degraded or nativeScanner.lastDegradation()
                     Log.d(TAG, "Detection result: ${corners?.contentToString()}")
+                    val orientation = nativeScanner.lastOrientation()
+                    if (corners != null &&
+                        orientation[1] >= NativeScanner.ORIENTATION_MIN_CONFIDENCE) {
+                        pageRotation = orientation[0].toInt()
+                    }
 
                     if (corners != null && corners.size == 8) {
                         runOnUiThread {
@@ -143,10 +181,136 @@ class CropActivity : AppCompatActivity() {
             finish()
         }
 
-        // Confirm → for now just show a toast (perspective transform will be added later)
-        findViewById<Button>(R.id.confirmButton).setOnClickListener {
-            Toast.makeText(this, "Document confirmed!", Toast.LENGTH_SHORT).show()
-            // TODO: perform perspective transform and return result
+        // Confirm → rectify the page and hand its path back to the caller
+        findViewById<Button>(R.id.confirmButton).setOnClickListener { button ->
+            val corners = toBitmapCorners(cropOverlay.corners) ?: return@setOnClickListener
+
+            button.isEnabled = false
+            Thread {
+                val result = rectifyPage(bitmap, corners)
+                runOnUiThread {
+                    if (result != null) {
+                        setResult(RESULT_OK, Intent()
+                            .putExtra(EXTRA_RESULT_PATH, result.first.absolutePath)
+                            .putExtra(EXTRA_THUMBNAIL_PATH, result.second.absolutePath)
+                            .putExtra(EXTRA_DEGRADED, degraded))
+                        finish()
+                    } else {
+                        button.isEnabled = true
+                        Toast.makeText(this, "Crop failed", Toast.LENGTH_SHORT).show()
+                    }
+                }
+            }.start()
+        }
+    }
+
+    override fun onDestroy() {
+        super.onDestroy()
+        nativeScanner.previewRelease(previewHandle)
+        previewHandle = 0L
+    }
+
+    private fun decodeWithinBudget(path: String): Bitmap? {
+        val bounds = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+        BitmapFactory.decodeFile(path, bounds)
+        val plan = nativeScanner.memoryPlan(bounds.outWidth, bounds.outHeight)
+            ?: return null
+        if (plan[NativeScanner.PLAN_FITS] == 0L) {
+            Log.w(TAG, "Over the memory budget even at its smallest plan")
+            return null
+        }
+        pagePixelLimit = plan[NativeScanner.PLAN_PAGE_PIXELS]
+        degraded = plan[NativeScanner.PLAN_DEGRADED].toInt()
+        return BitmapFactory.decodeFile(path, BitmapFactory.Options().apply {
+            inSampleSize = plan[NativeScanner.PLAN_SAMPLE].toInt()
+        })
+    }
+
+    // Corners in view coordinates to bitmap pixels, TL TR BR BL
+    private fun toBitmapCorners(viewCorners: Array<PointF>): FloatArray? {
+        val viewMatrix = cropOverlay.imageToViewMatrix ?: return null
+        val inverse = Matrix()
+        if (!viewMatrix.invert(inverse)) return null
+        val corners = FloatArray(8)
+        viewCorners.forEachIndexed { i, p ->
+            corners[i * 2] = p.x
+            corners[i * 2 + 1] = p.y
+        }
+        inverse.mapPoints(corners)
+        return corners
+    }
+
+    // Drag preview: the bitmap is sized from the page aspect when a drag
+    // starts and reused for every move, so the native side only repaints
+    // what the moving corner changed.  `viewCorners` is null at drag end.
+    private fun updatePreview(bitmap: Bitmap, viewCorners: Array<PointF>?) {
+        if (viewCorners == null || previewHandle == 0L) {
+            previewView.visibility = View.GONE
+            previewBitmap = null
+            return
+        }
+        val corners = toBitmapCorners(viewCorners) ?: return
+        val target = previewBitmap ?: run {
+            val (w, h) = outputSize(corners)
+            if (w < 2 || h < 2) return
+            val s = PREVIEW_SIZE.toFloat() / max(w, h)
+            Bitmap.createBitmap(max(1, (w * s).toInt()), max(1, (h * s).toInt()),
+                Bitmap.Config.ARGB_8888).also {
+                previewBitmap = it
+                previewView.setImageBitmap(it)
+            }
+        }
+        if (nativeScanner.previewRender(previewHandle, corners, target) > 0) {
+            previewView.invalidate()
+        }
+        previewView.visibility = View.VISIBLE
+    }
+
+    // Page size in source pixels: the longer of each pair of opposite edges
+    private fun outputSize(corners: FloatArray): Pair<Int, Int> {
+        fun edge(a: Int, b: Int) =
+            hypot(corners[b * 2] - corners[a * 2], corners[b * 2 + 1] - corners[a * 2 + 1])
+        return Pair(max(edge(0, 1), edge(3, 2)).toInt(), max(edge(0, 3), edge(1, 2)).toInt())
+    }
+
+    // Page size scaled down, aspect kept, to the memory plan's limit
+    private fun fitPage(size: Pair<Int, Int>): Pair<Int, Int> {
+        val area = size.first.toLong() * size.second
+        if (area <= pagePixelLimit) return size
+        degraded = degraded or NativeScanner.DEGRADED_PAGE
+        val s = sqrt(pagePixelLimit.toDouble() / area)
+        return Pair(max(1, (size.first * s).toInt()), max(1, (size.second * s).toInt()))
+    }
+
+    // The thumbnail comes out of the same native pass as the page.
+    private fun rectifyPage(bitmap: Bitmap, corners: FloatArray): Pair<File, File>? {
+        val rotation = pageRotation
+        val (outW, outH) = fitPage(outputSize(corners)).let {
+            if (rotation % 180 != 0) Pair(it.second, it.first) else it
+        }
+        if (outW < 2 || outH < 2) return null
+        val thumbScale = minOf(1f, THUMBNAIL_SIZE.toFloat() / max(outW, outH))
+        val thumbW = max(1, (outW * thumbScale).toInt())
+        val thumbH = max(1, (outH * thumbScale).toInt())
+
+        return try {
+            val page = Bitmap.createBitmap(outW, outH, Bitmap.Config.ARGB_8888)
+            val thumb = Bitmap.createBitmap(thumbW, thumbH, Bitmap.Config.ARGB_8888)
+            if (!nativeScanner.rectify(bitmap, corners, page, arrayOf(thumb),
+                    NativeScanner.ENHANCE_COLOR, rotation)) {
+                return null
+            }
+            val stamp = System.currentTimeMillis()
+            val pageFile = File(cacheDir, "page_$stamp.jpg")
+            val thumbFile = File(cacheDir, "page_${stamp}_thumb.jpg")
+            FileOutputStream(pageFile).use { page.compress(Bitmap.CompressFormat.JPEG, 95, it) }
+            FileOutputStream(thumbFile).use { thumb.compress(Bitmap.CompressFormat.JPEG, 85, it) }
+            page.recycle()
+            thumb.recycle()
+            Pair(pageFile, thumbFile)
+        } catch (e: Exception) {
+            Log.e(TAG, "Rectification failed", e)
+            null
         }
     }
 }
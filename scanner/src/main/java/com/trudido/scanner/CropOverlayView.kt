@@ -100,6 +100,9 @@ class CropOverlayView @JvmOverloads constructor(
     /** Image-to-view mapping (set by CropActivity after layout). */
     var imageToViewMatrix: Matrix? = null
 
+    /** Called with the corners on every drag move, and with null when the drag ends. */
+    var onCornerDrag: ((Array<PointF>?) -> Unit)? = null
+
     fun setNormalisedCorners(pts: Array<PointF>) {
         corners = Array(4) {
             PointF(pts[it].x * width, pts[it].y * height)
@@ -147,11 +150,13 @@ class CropOverlayView @JvmOverloads constructor(
                     corners[dragIndex].x = event.x.coerceIn(0f, width.toFloat())
                     corners[dragIndex].y = event.y.coerceIn(0f, height.toFloat())
                     dragPoint = PointF(corners[dragIndex].x, corners[dragIndex].y)
+                    onCornerDrag?.invoke(corners)
                     invalidate()
                     return true
                 }
             }
             MotionEvent.ACTION_UP, MotionEvent.ACTION_CANCEL -> {
+                if (dragIndex >= 0) onCornerDrag?.invoke(null)
                 dragIndex = -1
                 dragPoint = null
                 invalidate()
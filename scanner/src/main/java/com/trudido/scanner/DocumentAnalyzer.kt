@@ -18,6 +18,7 @@
 
 package com.trudido.scanner
 
+import android.graphics.Bitmap
 import android.os.Handler
 import android.os.Looper
 import androidx.camera.core.ImageAnalysis
@@ -25,14 +26,28 @@ import androidx.camera.core.ImageProxy
 import org.opencv.core.CvType
 import org.opencv.core.Mat
 
+/**
+ * Live preview detection.  With `fusionFrames` > 0 the last frames in
+ * which the document was found are also kept natively, so fusedPage()
+ * can return an instant multi-frame scan instead of a slow still.
+ */
 class DocumentAnalyzer(
     private val nativeScanner: NativeScanner,
-    private val overlayView: DocumentOverlayView
+    private val overlayView: DocumentOverlayView,
+    fusionFrames: Int = 0
 ) : ImageAnalysis.Analyzer {
 
     private val mainHandler = Handler(Looper.getMainLooper())
     private var lastAnalysisTime = 0L
-    private val analysisIntervalMs = 250L  // throttle to ~4 fps (heavy pipeline)
+    private val analysisIntervalMs = 100L  // ~10 fps, each frame runs a subset
+
+    // Strategies rotate across frames, so each frame stays within budget
+    private var temporalHandle = nativeScanner.temporalCreate(FRAME_BUDGET_MS)
+
+    private var fusionHandle =
+        if (fusionFrames > 0) nativeScanner.fusionCreate(fusionFrames) else 0L
+    @Volatile private var lastCorners: FloatArray? = null
+    @Volatile private var lastRotation = 0
 
     override fun analyze(image: ImageProxy) {
         val now = System.currentTimeMillis()
@@ -70,8 +85,17 @@ class DocumentAnalyzer(
             }
         }
 
-        // Use colour-aware detection (same pipeline as capture)
-        val corners = nativeScanner.findDocumentCornersColor(rgbaMat.nativeObjAddr)
+        // Same colour-aware strategies as capture, spread over frames,
+        // with the early "no document in view" gate
+        val corners = if (temporalHandle != 0L)
+            nativeScanner.temporalDetect(temporalHandle, rgbaMat.nativeObjAddr)
+        else null
+
+        if (fusionHandle != 0L && corners != null) {
+            nativeScanner.fusionPush(fusionHandle, rgbaMat.nativeObjAddr, corners)
+            lastCorners = corners
+            lastRotation = rotation
+        }
 
         mainHandler.post {
             overlayView.updateCorners(corners, imgW, imgH, rotation)
@@ -80,4 +104,42 @@ class DocumentAnalyzer(
         rgbaMat.release()
         image.close()
     }
-}
\ No newline at end of file
+
+    // Frees the native tracker.  Call once no analyze() can still be
+    // running (after clearAnalyzer() and the executor has drained).
+    fun close() {
+        nativeScanner.temporalRelease(temporalHandle)
+        temporalHandle = 0L
+        nativeScanner.fusionRelease(fusionHandle)
+        fusionHandle = 0L
+    }
+
+    /**
+     * Fuses the recent frames into an upright, enhanced page, `upscale`
+     * times the page's size in the preview frames.  Null when the
+     * document has not been tracked yet.  Call off the main thread.
+     */
+    fun fusedPage(enhanceMode: Int, upscale: Float = 1f): Bitmap? {
+        val corners = lastCorners ?: return null
+        if (fusionHandle == 0L) return null
+        fun edge(a: Int, b: Int) = Math.hypot(
+            (corners[b * 2] - corners[a * 2]).toDouble(),
+            (corners[b * 2 + 1] - corners[a * 2 + 1]).toDouble())
+        val w = (maxOf(edge(0, 1), edge(3, 2)) * upscale).toInt()
+        val h = (maxOf(edge(0, 3), edge(1, 2)) * upscale).toInt()
+        if (w < 2 || h < 2) return null
+        val rotation = lastRotation
+        val page = if (rotation % 180 != 0)
+            Bitmap.createBitmap(h, w, Bitmap.Config.ARGB_8888)
+        else Bitmap.createBitmap(w, h, Bitmap.Config.ARGB_8888)
+        if (nativeScanner.fusionRender(fusionHandle, page, enhanceMode, rotation) == 0) {
+            page.recycle()
+            return null
+        }
+        return page
+    }
+
+    companion object {
+        private const val FRAME_BUDGET_MS = 25f
+    }
+}
@@ -18,16 +18,260 @@
 
 package com.trudido.scanner
 
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.graphics.BitmapRegionDecoder
+import android.graphics.Rect
+
 class NativeScanner {
     companion object {
         init {
             System.loadLibrary("scanner")
         }
+
+        // Values returned by lastRejectReason()
+        const val REJECT_NONE = 0
+        const val REJECT_LOW_CONTRAST = 1
+        const val REJECT_NO_STRAIGHT_EDGES = 2
+
+        // Enhancement applied by rectify()
+        const val ENHANCE_NONE = 0
+        const val ENHANCE_COLOR = 1
+        const val ENHANCE_GRAY = 2
+
+        // lastOrientation() confidence worth acting on
+        const val ORIENTATION_MIN_CONFIDENCE = 0.6f
+
+        // Stages reported to SessionListener.onProgress
+        const val SESSION_QUEUED = 0
+        const val SESSION_DETECTED = 1
+        const val SESSION_RECTIFIED = 2
+        const val SESSION_DELIVERED = 3
+        const val SESSION_FAILED = 4
+
+        // Flags of lastDegradation(), sessionDegradation() and
+        // memoryPlan(): what the memory budget cost
+        const val DEGRADED_NONE = 0
+        const val DEGRADED_WORKING_SIZE = 1   // detection below 600 px
+        const val DEGRADED_SOURCE = 2         // still decoded subsampled
+        const val DEGRADED_PAGE = 4           // page smaller than its source
+        const val DEGRADED_PIPELINE = 8       // session pages one at a time
+        const val DEGRADED_OVER_BUDGET = 16   // not detected: no plan fits
+
+        // Indices into memoryPlan()
+        const val PLAN_SAMPLE = 0
+        const val PLAN_WORKING_SIDE = 1
+        const val PLAN_PAGE_PIXELS = 2
+        const val PLAN_PEAK_BYTES = 3
+        const val PLAN_DEGRADED = 4
+        const val PLAN_FITS = 5
+
+        // Native working resolution (longer side) of the detector
+        private const val WORKING_SIZE = 600
+        private const val STRIP_ROWS = 128
     }
 
-    // Live preview: grayscale single-channel Mat
+    // Live preview: RGBA/BGR/gray Mat.  Frames that cannot contain a
+    // document are rejected before the full pipeline runs.
     external fun findDocumentCorners(matAddr: Long): FloatArray?
 
-    // Captured image: full-colour BGR Mat
+    // Captured image: full-colour Mat, always runs every strategy
     external fun findDocumentCornersColor(matAddr: Long): FloatArray?
-}
\ No newline at end of file
+
+    // Captured image read straight from an ARGB_8888 bitmap (no copy)
+    external fun findDocumentCornersBitmap(bitmap: Bitmap): FloatArray?
+
+    // Streaming ingest: declare the source size, push row strips top to
+    // bottom, then finish to detect (or cancel).  Only the ~600 px
+    // working image is held natively.
+    external fun ingestBegin(width: Int, height: Int): Long
+    external fun ingestPush(handle: Long, strip: Bitmap): Boolean
+    external fun ingestFinish(handle: Long): FloatArray?
+    external fun ingestCancel(handle: Long)
+
+    /**
+     * Detects the document in an image file without decoding it whole.
+     * Row bands are decoded one at a time (subsampled by the decoder
+     * while still at least twice the working size), pushed and freed,
+     * so peak memory does not grow with sensor resolution.  Corners are
+     * returned in full-resolution image coordinates.
+     */
+    fun findDocumentCornersInFile(path: String): FloatArray? {
+        val bounds = BitmapFactory.Options().apply { inJustDecodeBounds = true }
+        BitmapFactory.decodeFile(path, bounds)
+        val fullW = bounds.outWidth
+        val fullH = bounds.outHeight
+        if (fullW <= 0 || fullH <= 0) return null
+
+        var sample = 1
+        while (maxOf(fullW, fullH) / (sample * 2) >= WORKING_SIZE * 2) sample *= 2
+        val srcW = (fullW + sample - 1) / sample
+        val srcH = (fullH + sample - 1) / sample
+
+        @Suppress("DEPRECATION")
+        val decoder = BitmapRegionDecoder.newInstance(path, false) ?: return null
+        val handle = ingestBegin(srcW, srcH)
+        if (handle == 0L) {
+            decoder.recycle()
+            return null
+        }
+        val opts = BitmapFactory.Options().apply {
+            inSampleSize = sample
+            inPreferredConfig = Bitmap.Config.ARGB_8888
+        }
+        try {
+            val stripRows = STRIP_ROWS * sample
+            var y = 0
+            while (y < fullH) {
+                val region = Rect(0, y, fullW, minOf(y + stripRows, fullH))
+                val strip = decoder.decodeRegion(region, opts) ?: break
+                ingestPush(handle, strip)
+                strip.recycle()
+                y += stripRows
+            }
+        } catch (e: Exception) {
+            ingestCancel(handle)
+            decoder.recycle()
+            throw e
+        }
+        decoder.recycle()
+
+        val corners = ingestFinish(handle) ?: return null
+        val sx = fullW.toFloat() / srcW
+        val sy = fullH.toFloat() / srcH
+        for (i in 0 until 4) {
+            corners[i * 2] *= sx
+            corners[i * 2 + 1] *= sy
+        }
+        return corners
+    }
+
+    // Temporal live-preview mode: each call runs the next strategies in
+    // rotation for about `budgetMs` and fuses candidates over the last
+    // few frames.  One handle per camera stream; release when done.
+    external fun temporalCreate(budgetMs: Float): Long
+    external fun temporalDetect(handle: Long, matAddr: Long): FloatArray?
+    external fun temporalReset(handle: Long)
+    external fun temporalRelease(handle: Long)
+
+    // Canny thresholds derived from each frame's gradient statistics
+    // (default), falling back to the fixed sweep only when the chosen
+    // level finds nothing.  Off: always sweep.  Process-wide.
+    external fun setAdaptiveCanny(enabled: Boolean)
+
+    // Runs one synthetic detection at the given frame size so the first
+    // real frame does not pay for lazy initialisation.  Call off the
+    // main thread, ideally while the camera is opening.
+    external fun warmUp(width: Int, height: Int): Boolean
+
+    // Why the last call on this thread returned null without searching
+    external fun lastRejectReason(): Int
+
+    // [degrees, confidence] of the page found by the last still-image
+    // detection on this thread: the clockwise turn that makes it
+    // upright.  Trust it above ORIENTATION_MIN_CONFIDENCE.
+    external fun lastOrientation(): FloatArray
+
+    // Native memory budget in bytes for low-RAM devices; 0 (the
+    // default) lifts it.  Detection, capture plans and sessions then
+    // pick decode subsampling, working size, page size and overlap so
+    // the accounted peak fits it, and report what they gave up; a
+    // source no plan fits is not detected (DEGRADED_OVER_BUDGET).
+    // OpenCV runs single-threaded while it is set.  The detector's
+    // share of the peak is the worst measured so far (warmUp() takes
+    // the first measurement) plus a worst-case reserve for its other
+    // heap, so an unusually heavy frame can still overshoot it once.
+    // Process-wide.
+    external fun setMemoryBudget(bytes: Long)
+
+    // Plan for a still of width x height under the budget, indexed by
+    // PLAN_*: decode it with inSampleSize = PLAN_SAMPLE and render pages
+    // of at most PLAN_PAGE_PIXELS.  PLAN_FITS is 0 when even the
+    // smallest plan is over budget.
+    external fun memoryPlan(width: Int, height: Int): LongArray?
+
+    // DEGRADED_* flags of the last detection on this thread
+    external fun lastDegradation(): Int
+
+    // Slow-frame flight recorder.  Per-stage timings of the last
+    // detections are always kept; a detection slower than `thresholdMs`
+    // writes its working image (slow_<n>.ppm) and timing report
+    // (slow_<n>.txt) into `dir`, which must exist.  Null `dir` or a
+    // threshold <= 0 disables snapshots.
+    external fun flightRecorderConfigure(dir: String?, thresholdMs: Float)
+
+    // Timings of the last detections, one line each, oldest first
+    external fun flightRecorderDump(): String
+
+    // Native buffer pool counters, for profiling:
+    // [hits, misses, cachedBytes, liveBlocks, liveBytes, peakBytes]
+    external fun matPoolStats(): LongArray
+
+    // Warp the quad (TL, TR, BR, BL in src pixels) into dst, enhancing
+    // and packing RGBA in one pass.  Each bitmap in `downsampled` (no
+    // larger than dst) receives an area-averaged copy from the same
+    // pass.  `rotation` (0, 90, 180, 270) turns the page clockwise in
+    // the same pass; size dst for the turned page.  All bitmaps must be
+    // ARGB_8888.  Returns false, leaving them untouched, for corners no
+    // perspective maps onto (collinear, concave, crossed or not finite)
+    // or an enhanceMode other than ENHANCE_*.
+    external fun rectify(
+        src: Bitmap, corners: FloatArray, dst: Bitmap,
+        downsampled: Array<Bitmap>, enhanceMode: Int, rotation: Int
+    ): Boolean
+
+    // Low-resolution rectified preview for corner dragging.  Create once
+    // per source (kept downsampled to `maxSide`), then render into the
+    // same ARGB_8888 bitmap on every move: only tiles whose source
+    // footprint moved are repainted.  Returns the tiles repainted, -1
+    // for corners rectify() would reject.
+    external fun previewCreate(src: Bitmap, maxSide: Int): Long
+    external fun previewRender(handle: Long, corners: FloatArray, dst: Bitmap): Int
+    external fun previewRelease(handle: Long)
+
+    // Multi-frame fused capture.  Push each preview frame (RGBA Mat)
+    // with the corners tracked in it; render aligns the last `capacity`
+    // frames on the page, merges them with a trimmed mean and writes the
+    // denoised page into `dst` (ARGB_8888, sized for the page after
+    // `rotation`; up to ~1.5x the preview's page size adds detail).
+    // Returns the number of frames merged, 0 when there was nothing or
+    // enhanceMode is not one of ENHANCE_*.
+    external fun fusionCreate(capacity: Int): Long
+    external fun fusionPush(handle: Long, matAddr: Long, corners: FloatArray)
+    external fun fusionRender(handle: Long, dst: Bitmap, enhanceMode: Int, rotation: Int): Int
+    external fun fusionReset(handle: Long)
+    external fun fusionRelease(handle: Long)
+
+    // Callbacks of a scanning session, invoked on native worker threads.
+    // `page` and `thumbnail` belong to the listener once onPage returns;
+    // `corners` are the quad used (TL TR BR BL, source pixels).
+    interface SessionListener {
+        fun onProgress(index: Int, stage: Int)
+        fun onPage(index: Int, page: Bitmap, thumbnail: Bitmap, corners: FloatArray)
+    }
+
+    // Multi-page scanning: detection, rectification and delivery run on
+    // separate native threads, so page N + 1 is detected while page N
+    // is being warped and page N - 1 encoded by the listener.  With
+    // `autoRotate`, pages found sideways or upside down are turned
+    // upright during the warp.  sessionCreate returns 0 for an
+    // enhanceMode other than ENHANCE_*; a page whose corners rectify()
+    // would reject is reported SESSION_FAILED.
+    // sessionSubmit takes an ARGB_8888 bitmap (kept pinned until it is
+    // rectified) and optional corners that skip detection; it returns
+    // the page index, or -1 when the queue is full and `wait` is false.
+    // sessionFinish drains the queues and blocks; call it off the main
+    // thread, then release.  Under a memory budget, submit also waits
+    // for earlier pages to free their share; sessionDegradation reports
+    // the DEGRADED_* flags of the pages so far.
+    external fun sessionCreate(
+        listener: SessionListener, enhanceMode: Int,
+        thumbnailSize: Int, queueDepth: Int, autoRotate: Boolean
+    ): Long
+    external fun sessionSubmit(
+        handle: Long, bitmap: Bitmap, corners: FloatArray?, wait: Boolean
+    ): Int
+    external fun sessionFinish(handle: Long)
+    external fun sessionDegradation(handle: Long): Int
+    external fun sessionRelease(handle: Long)
+}
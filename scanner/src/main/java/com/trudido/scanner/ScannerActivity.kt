@@ -19,11 +19,13 @@
 package com.trudido.scanner
 
 import android.Manifest
+import android.app.ActivityManager
 import android.content.Intent
 import android.content.pm.PackageManager
 import android.os.Bundle
 import android.widget.Button
 import android.widget.Toast
+import androidx.activity.result.contract.ActivityResultContracts
 import androidx.appcompat.app.AppCompatActivity
 import androidx.camera.core.*
 import androidx.camera.lifecycle.ProcessCameraProvider
@@ -36,9 +38,30 @@ import java.io.File
 
 class ScannerActivity : AppCompatActivity() {
 
+    companion object {
+        // Typical capture aspect; detection itself runs at ~600 px
+        private const val WARM_UP_WIDTH = 1280
+        private const val WARM_UP_HEIGHT = 960
+        private const val SLOW_FRAME_MS = 200f   // flight recorder snapshot threshold
+        private const val SLOW_FRAME_DIR = "slow_frames"
+        // Native memory budget on devices with this much RAM or less
+        private const val LOW_RAM_TOTAL = 2L shl 30
+        private const val LOW_RAM_BUDGET = 96L shl 20
+    }
+
     private lateinit var viewFinder: PreviewView
     private var imageCapture: ImageCapture? = null
 
+    // A confirmed crop finishes the scanner with the page as our result
+    private val cropLauncher = registerForActivityResult(
+        ActivityResultContracts.StartActivityForResult()
+    ) { result ->
+        if (result.resultCode == RESULT_OK) {
+            setResult(RESULT_OK, result.data)
+            finish()
+        }
+    }
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         setContentView(R.layout.activity_scanner)
@@ -47,6 +70,16 @@ class ScannerActivity : AppCompatActivity() {
 
         OpenCVLoader.initLocal()
 
+        // Pay native start-up costs while the camera opens
+        Thread {
+            val slowFrames = File(filesDir, SLOW_FRAME_DIR).apply { mkdirs() }
+            NativeScanner().apply {
+                if (isLowRam()) setMemoryBudget(LOW_RAM_BUDGET)
+                flightRecorderConfigure(slowFrames.absolutePath, SLOW_FRAME_MS)
+                warmUp(WARM_UP_WIDTH, WARM_UP_HEIGHT)
+            }
+        }.start()
+
         if (allPermissionsGranted()) {
             startCamera()
         } else {
@@ -71,7 +104,7 @@ class ScannerActivity : AppCompatActivity() {
                 override fun onImageSaved(output: ImageCapture.OutputFileResults) {
                     val intent = Intent(this@ScannerActivity, CropActivity::class.java)
                     intent.putExtra(CropActivity.EXTRA_IMAGE_PATH, photoFile.absolutePath)
-                    startActivity(intent)
+                    cropLauncher.launch(intent)
                 }
                 override fun onError(exc: ImageCaptureException) {
                     Log.e("ScannerActivity", "Photo capture failed: ${exc.message}", exc)
@@ -127,4 +160,10 @@ class ScannerActivity : AppCompatActivity() {
     private fun allPermissionsGranted() = ContextCompat.checkSelfPermission(
         this, Manifest.permission.CAMERA
     ) == PackageManager.PERMISSION_GRANTED
+
+    private fun isLowRam(): Boolean {
+        val am = getSystemService(ActivityManager::class.java)
+        val info = ActivityManager.MemoryInfo().also { am.getMemoryInfo(it) }
+        return am.isLowRamDevice || info.totalMem <= LOW_RAM_TOTAL
+    }
 }
\ No newline at end of file
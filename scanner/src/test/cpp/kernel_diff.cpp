@@ -0,0 +1,490 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Differential harness: runs the detector's kernels against the
+// reference oracles in reference_kernels.h on randomised synthetic
+// frames and, optionally, a corpus of photos, and reports the largest
+// disagreement per kernel.  The quad detectDocument() selects can be
+// recorded once and checked after every optimisation:
+//
+//   kernel_diff --random 200 --corpus photos/ --record golden.txt
+//   ... rewrite a kernel ...
+//   kernel_diff --random 200 --corpus photos/ --check golden.txt
+//
+// The memory a detection takes is metered as the app meters it and
+// checked against the budget model in memory_budget.cpp (as a fraction
+// of it).  Page orientation is checked on synthetic text pages turned
+// by each quarter turn: above ORIENTATION_MIN_CONFIDENCE it must be
+// right.
+//
+// Exits non-zero when a kernel exceeds its tolerance or a selected quad
+// moved.
+
+// The kernels under test are file-local to the detector
+#include "detector.cpp"
+#include "ingest.h"
+#include "mat_pool.h"
+#include "memory_budget.h"
+#include "reference_kernels.h"
+#include "synthetic_page.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct Case {
+    std::string name;
+    cv::Mat bgr;    // working resolution
+    cv::Mat gray;
+};
+
+struct KernelStat {
+    KernelStat(const char* name, const char* unit, double tolerance)
+        : name(name), unit(unit), tolerance(tolerance) {}
+
+    const char* name;
+    const char* unit;
+    double tolerance;
+    int cases = 0;
+    double maxError = 0;
+    std::string worst;
+
+    void add(const Case& c, double error) {
+        cases++;
+        if (error > maxError || worst.empty()) {
+            if (error > maxError) maxError = error;
+            worst = c.name;
+        }
+    }
+    bool ok() const { return maxError <= tolerance; }
+};
+
+// --- inputs -------------------------------------------------------
+
+Case randomCase(uint64_t seed, int i) {
+    Case k;
+    k.name = "random-" + std::to_string(seed) + "-" + std::to_string(i);
+    k.bgr = syntheticPage(seed, i, TARGET).bgr;
+    cv::cvtColor(k.bgr, k.gray, cv::COLOR_BGR2GRAY);
+    return k;
+}
+
+std::vector<Case> corpusCases(const std::string& dir) {
+    std::vector<cv::String> files;
+    cv::glob(dir, files, false);
+    std::vector<Case> cases;
+    for (const auto& f : files) {
+        cv::Mat img = cv::imread(f, cv::IMREAD_COLOR);
+        if (img.empty()) continue;
+        Case k;
+        k.name = f;
+        double scale;
+        k.bgr = ingestFrame(img, TARGET, scale);
+        cv::cvtColor(k.bgr, k.gray, cv::COLOR_BGR2GRAY);
+        cases.push_back(k);
+    }
+    return cases;
+}
+
+// Quads to score: the detector's own candidates would be biased toward
+// clean edges, so random ones (some partly outside) are added.
+std::vector<std::vector<cv::Point>> probeQuads(const Case& c) {
+    cv::RNG rng(std::hash<std::string>()(c.name));
+    int w = c.gray.cols, h = c.gray.rows;
+    std::vector<std::vector<cv::Point>> quads;
+    for (int i = 0; i < 32; i++) {
+        std::vector<cv::Point> q(4);
+        for (auto& p : q)
+            p = {rng.uniform(-w / 10, w + w / 10), rng.uniform(-h / 10, h + h / 10)};
+        quads.push_back(q);
+    }
+    return quads;
+}
+
+// A page-shaped mask with a triangular notch bitten out of one edge,
+// so the contour checks also see a concave blob.
+cv::Mat notchedPage(const Case& c) {
+    cv::RNG rng(std::hash<std::string>()(c.name) + 1);
+    int w = c.gray.cols, h = c.gray.rows;
+    cv::Point2f centre(w * rng.uniform(0.4f, 0.6f), h * rng.uniform(0.4f, 0.6f));
+    cv::RotatedRect rect(centre, cv::Size2f(w * rng.uniform(0.4f, 0.8f),
+                                            h * rng.uniform(0.4f, 0.8f)),
+                         rng.uniform(-45.f, 45.f));
+    cv::Point2f v[4];
+    rect.points(v);
+    cv::Mat mask(h, w, CV_8UC1, cv::Scalar(0));
+    std::vector<cv::Point> page(v, v + 4);
+    cv::fillConvexPoly(mask, page, cv::Scalar(255));
+
+    int e = rng.uniform(0, 4);
+    cv::Point2f a = v[e], b = v[(e + 1) % 4];
+    float t = rng.uniform(0.3f, 0.7f), depth = rng.uniform(0.1f, 0.3f);
+    cv::Point2f mid = a + (b - a) * t;
+    std::vector<cv::Point> notch = {a + (b - a) * (t - 0.08f),
+                                    mid + (centre - mid) * depth,
+                                    a + (b - a) * (t + 0.08f)};
+    cv::fillConvexPoly(mask, notch, cv::Scalar(0));
+    return mask;
+}
+
+// --- comparisons ----------------------------------------------------
+
+double maxAbsDiff(const cv::Mat& a, const cv::Mat& b) {
+    if (a.size() != b.size() || a.type() != b.type()) return INFINITY;
+    return cv::norm(a, b, cv::NORM_INF);
+}
+
+// Candidates present in one list but not the other; corners may be
+// listed from any starting point.
+double quadSetDifference(const std::vector<Candidate>& a,
+                         const std::vector<Candidate>& b) {
+    auto same = [](const std::vector<cv::Point>& p,
+                   const std::vector<cv::Point>& q) {
+        for (int r = 0; r < 4; r++) {
+            bool all = true;
+            for (int i = 0; i < 4 && all; i++) all = p[i] == q[(i + r) % 4];
+            if (all) return true;
+        }
+        return false;
+    };
+    auto missing = [&](const std::vector<Candidate>& from,
+                       const std::vector<Candidate>& in) {
+        int n = 0;
+        for (const auto& x : from) {
+            bool found = false;
+            for (const auto& y : in) found = found || same(x.quad, y.quad);
+            if (!found) n++;
+        }
+        return n;
+    };
+    return missing(a, b) + missing(b, a);
+}
+
+// Contours present in one list but not the other, point for point
+double contourSetDifference(std::vector<std::vector<cv::Point>> a,
+                            std::vector<std::vector<cv::Point>> b) {
+    auto less = [](const std::vector<cv::Point>& p,
+                   const std::vector<cv::Point>& q) {
+        return std::lexicographical_compare(
+            p.begin(), p.end(), q.begin(), q.end(),
+            [](cv::Point u, cv::Point v) {
+                return u.x != v.x ? u.x < v.x : u.y < v.y;
+            });
+    };
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+    std::vector<std::vector<cv::Point>> onlyOne;
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(),
+                                  std::back_inserter(onlyOne), less);
+    return (double)onlyOne.size();
+}
+
+double quadDistance(const std::vector<cv::Point>& a,
+                    const std::vector<cv::Point>& b) {
+    if (a.size() != b.size()) return INFINITY;
+    double d = 0;
+    for (size_t i = 0; i < a.size(); i++) d = std::max(d, cv::norm(a[i] - b[i]));
+    return d;
+}
+
+std::string quadToString(const std::vector<cv::Point>& q) {
+    std::ostringstream s;
+    s << q.size();
+    for (const auto& p : q) s << ' ' << p.x << ' ' << p.y;
+    return s.str();
+}
+
+std::vector<cv::Point> quadFromString(std::istringstream& in) {
+    size_t n = 0;
+    in >> n;
+    std::vector<cv::Point> q(n);
+    for (auto& p : q) in >> p.x >> p.y;
+    return q;
+}
+
+void runKernels(const Case& c, std::vector<KernelStat>& stats) {
+    int s = 0;
+    cv::Mat mag = refGradientMagnitude(c.gray);
+    ColorPlanes planes;
+    planes.compute(c.bgr, PLANE_ALL);
+
+    // gradient_field: every pixel of the lazy field
+    {
+        GradientField field(c.gray), fromBgr(c.bgr);
+        cv::Mat lazy(mag.size(), CV_32F), sampled(mag.size(), CV_32F),
+                colour(mag.size(), CV_32F);
+        for (int y = 0; y < mag.rows; y++)
+            for (int x = 0; x < mag.cols; x++) {
+                lazy.at<float>(y, x) = field.at(x, y);
+                sampled.at<float>(y, x) = field.sample(x, y);
+                colour.at<float>(y, x) = fromBgr.at(x, y);
+            }
+        stats[s++].add(c, std::max({maxAbsDiff(lazy, mag),
+                                    maxAbsDiff(sampled, mag),
+                                    maxAbsDiff(colour, mag)}));
+    }
+    // edge_score
+    {
+        GradientField field(c.gray);
+        double err = 0;
+        for (const auto& q : probeQuads(c))
+            err = std::max(err, std::abs(computeEdgeScore(q, field) -
+                                         refEdgeScore(q, mag)));
+        stats[s++].add(c, err);
+    }
+    // color_gray, saturation, lab: the shared colour planes
+    stats[s++].add(c, maxAbsDiff(planes.gray, c.gray));
+    stats[s++].add(c, maxAbsDiff(planes.sat, refSaturation(c.bgr)));
+    {
+        std::vector<cv::Mat> lab = refLab(c.bgr);
+        stats[s++].add(c, std::max({maxAbsDiff(planes.L, lab[0]),
+                                    maxAbsDiff(planes.a, lab[1]),
+                                    maxAbsDiff(planes.b, lab[2])}));
+    }
+    // otsu
+    {
+        int hist[256] = {0};
+        for (int y = 0; y < c.gray.rows; y++)
+            for (int x = 0; x < c.gray.cols; x++) hist[c.gray.at<uchar>(y, x)]++;
+        stats[s++].add(c, std::abs(otsuThreshold(hist, (int)c.gray.total()) -
+                                   refOtsu(c.gray)));
+    }
+    // color_distance
+    stats[s++].add(c, maxAbsDiff(planes.distance, refColorDistance(c.bgr)));
+    // threshold_levels: pixels that differ, over a spread of levels
+    {
+        int levels[] = {16, 64, 100, 128, 160, 200, 240};
+        const int n = (int)(sizeof(levels) / sizeof(levels[0]));
+        RleMask masks[n];
+        RleMask::thresholdLevels(c.gray, levels, n, masks);
+        double err = 0;
+        for (int l = 0; l < n; l++)
+            err = std::max(err, (double)cv::countNonZero(
+                masks[l].toMat() != refThreshold(c.gray, levels[l])));
+        stats[s++].add(c, err);
+    }
+    // morphology: the close/open chains the strategies use
+    {
+        cv::Mat mask = refThreshold(c.gray, refOtsu(c.gray) + 1);
+        RleMask rle = RleMask::fromMask(mask);
+        cv::Mat closed = refMorphology(mask, cv::MORPH_CLOSE, 5, 5, 3);
+        cv::Mat opened = refMorphology(closed, cv::MORPH_OPEN, 3, 3, 1);
+        RleMask rc = rle.closed(5, 5, 3);
+        double err = std::max(cv::countNonZero(rc.toMat() != closed),
+                              cv::countNonZero(rc.opened(3, 3).toMat() != opened));
+        stats[s++].add(c, err);
+    }
+    // outer_contours: the streaming tracer vs cv::findContours, on a
+    // dilated edge map and on a raw threshold mask full of specks
+    {
+        cv::Mat edges;
+        cv::Canny(c.gray, edges, 20, 60);
+        cv::dilate(edges, edges, cv::Mat());
+        double err = 0;
+        for (const cv::Mat& m : {edges, refThreshold(c.gray, refOtsu(c.gray) + 1)}) {
+            cv::Mat marks = m.clone();
+            std::vector<std::vector<cv::Point>> traced;
+            for (auto& t : traceOuterContours(marks, 0, INT_MAX))
+                traced.push_back(std::move(t.points));
+            err = std::max(err, contourSetDifference(traced, refOuterContours(m)));
+        }
+        stats[s++].add(c, err);
+    }
+    // contours: candidates from a run-length mask vs the byte mask, on
+    // the closed threshold masks and on a notched page
+    {
+        cv::Mat mask = refMorphology(refThreshold(c.gray, refOtsu(c.gray) + 1),
+                                     cv::MORPH_CLOSE, 5, 5, 3);
+        double area = (double)mask.total();
+        double err = 0;
+        for (const cv::Mat& m : {mask, cv::Mat(255 - mask), notchedPage(c)}) {
+            std::vector<Candidate> ref, fast;
+            collectQuads(m, area, ref);
+            collectQuads(RleMask::fromMask(m), area, fast);
+            err = std::max(err, quadSetDifference(fast, ref));
+        }
+        stats[s++].add(c, err);
+    }
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: kernel_diff [--random N] [--seed S] [--corpus GLOB]\n"
+        "                   [--record FILE | --check FILE]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int randomCount = 100;
+    uint64_t seed = 1;
+    std::string corpus, recordPath, checkPath;
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (!std::strcmp(argv[i], "--random")) randomCount = std::atoi(next());
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(next(), nullptr, 10);
+        else if (!std::strcmp(argv[i], "--corpus")) corpus = next();
+        else if (!std::strcmp(argv[i], "--record")) recordPath = next();
+        else if (!std::strcmp(argv[i], "--check")) checkPath = next();
+        else { usage(); return 2; }
+    }
+
+    std::vector<Case> cases;
+    for (int i = 0; i < randomCount; i++) cases.push_back(randomCase(seed, i));
+    if (!corpus.empty()) {
+        auto more = corpusCases(corpus);
+        cases.insert(cases.end(), more.begin(), more.end());
+    }
+
+    // Error units: bit-exact kernels compare values, masks count pixels,
+    // contours count contours or quads found by only one side.  Lab comes
+    // from an interpolated table, so it and the distance built on it
+    // may be off by a level or two.
+    std::vector<KernelStat> stats = {
+        {"gradient_field", "value", 0},
+        {"edge_score", "value", 0},
+        {"color_gray", "value", 0},
+        {"saturation", "value", 0},
+        {"lab", "value", 2},
+        {"otsu", "level", 0},
+        {"color_distance", "value", 3},
+        {"threshold_levels", "pixels", 0},
+        {"morphology", "pixels", 0},
+        {"outer_contours", "contours", 0},
+        {"contours", "quads", 0},
+    };
+    KernelStat bounded{"bounded_score", "px", 0};
+    KernelStat streaming{"streaming_contours", "px", 0};
+    KernelStat memory{"detection_memory", "model", 1};
+    KernelStat selected{"selected_quad", "px", 0};
+
+    std::map<std::string, std::vector<cv::Point>> golden;
+    if (!checkPath.empty()) {
+        std::ifstream in(checkPath);
+        if (!in) {
+            std::fprintf(stderr, "cannot read %s\n", checkPath.c_str());
+            return 2;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string name;
+            if (std::getline(fields, name, '\t'))
+                golden[name] = quadFromString(fields);
+        }
+    }
+    std::ofstream record;
+    if (!recordPath.empty()) record.open(recordPath);
+
+    for (const Case& c : cases) {
+        runKernels(c, stats);
+
+        std::vector<cv::Point> quad = detectDocument(c.bgr, 1.0, false);
+
+        // Bounded scoring must pick exactly what exhaustive scoring picks
+        setBoundedScoring(false);
+        std::vector<cv::Point> exhaustive = detectDocument(c.bgr, 1.0, false);
+        setBoundedScoring(true);
+        bounded.add(c, quadDistance(quad, exhaustive));
+        // The streaming tracer must not move the pick either; until this
+        // passes, collectQuads keeps cv::findContours
+        setStreamingContours(true);
+        std::vector<cv::Point> streamed = detectDocument(c.bgr, 1.0, false);
+        setStreamingContours(false);
+        streaming.add(c, quadDistance(quad, streamed));
+
+        // Metered as the app meters it, against the model as it stood
+        // before this frame (the prior, raised by earlier frames): above
+        // 1, a plan made then would have been short
+        long long model = detectionBytes(c.bgr.cols, c.bgr.rows);
+        PooledMatAllocator* pool = new PooledMatAllocator(0);
+        long long used;
+        {
+            ScopedMatPool bind(pool);
+            DetectionMeter meter(pool);
+            PageOrientation orientation;
+            detectDocument(c.bgr, 1.0, false, &orientation);
+            used = meter.record(c.bgr.size());
+        }
+        pool->retire();
+        memory.add(c, (double)used / model);
+
+        if (record.is_open()) record << c.name << '\t' << quadToString(quad) << '\n';
+        auto g = golden.find(c.name);
+        if (g != golden.end()) {
+            double d = quadDistance(quad, g->second);
+            selected.add(c, d);
+            if (d > 0)
+                std::printf("selected quad moved: %s  [%s] -> [%s]\n",
+                            c.name.c_str(), quadToString(g->second).c_str(),
+                            quadToString(quad).c_str());
+        }
+    }
+
+    // Sessions and CropActivity turn pages on their own above the gate,
+    // so a confident answer must never be wrong; how many pages clear
+    // the gate is reported, not checked
+    KernelStat orientation{"orientation", "pages", 0};
+    int confident = 0;
+    for (int i = 0; i < randomCount; i++) {
+        for (int rotation = 0; rotation < 360; rotation += 90) {
+            SyntheticTextPage p = syntheticTextPage(seed, i, TARGET, rotation);
+            Case c;
+            c.name = "text-" + std::to_string(seed) + "-" + std::to_string(i) +
+                     "-" + std::to_string(rotation);
+            PageOrientation o = estimatePageOrientation(p.bgr, 1.0, p.corners);
+            bool confidentEnough = o.confidence >= ORIENTATION_MIN_CONFIDENCE;
+            confident += confidentEnough;
+            orientation.add(c, confidentEnough && o.degrees != p.degrees);
+        }
+    }
+    if (orientation.cases)
+        std::printf("orientation: %d of %d text pages above the gate\n",
+                    confident, orientation.cases);
+
+    stats.push_back(bounded);
+    stats.push_back(streaming);
+    stats.push_back(orientation);
+    stats.push_back(memory);
+    if (selected.cases) stats.push_back(selected);
+
+    bool ok = true;
+    std::printf("%-18s %7s %12s %10s %-7s %s\n",
+                "kernel", "cases", "max error", "tolerance", "unit", "worst case");
+    for (const auto& k : stats) {
+        std::printf("%-18s %7d %12g %10g %-7s %s%s\n", k.name, k.cases,
+                    k.maxError, k.tolerance, k.unit, k.worst.c_str(),
+                    k.ok() ? "" : "  FAIL");
+        ok = ok && k.ok();
+    }
+    return ok ? 0 : 1;
+}
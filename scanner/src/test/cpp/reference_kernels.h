@@ -0,0 +1,151 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <vector>
+
+// ===================================================================
+// Reference oracles for the detector's hot kernels.
+//
+// Each one is the plain OpenCV formulation (or, where none exists, the
+// original scalar loop) that an optimised kernel must reproduce.  Keep
+// these simple and slow on purpose: they define what "correct" means
+// when a kernel is rewritten with SIMD, fixed point or fusion.
+// ===================================================================
+
+// Dense 3x3 Sobel magnitude (CV_32F, BORDER_REFLECT_101).
+inline cv::Mat refGradientMagnitude(const cv::Mat& gray) {
+    cv::Mat gx, gy, mag;
+    cv::Sobel(gray, gx, CV_32F, 1, 0, 3, 1, 0, cv::BORDER_REFLECT_101);
+    cv::Sobel(gray, gy, CV_32F, 0, 1, 3, 1, 0, cv::BORDER_REFLECT_101);
+    cv::magnitude(gx, gy, mag);
+    return mag;
+}
+
+// Mean gradient magnitude along the quad's edges, read from a dense
+// magnitude image.
+inline double refEdgeScore(const std::vector<cv::Point>& quad,
+                           const cv::Mat& mag) {
+    double total = 0;
+    int samples = 0;
+    for (int i = 0; i < 4; i++) {
+        cv::Point p1 = quad[i], p2 = quad[(i + 1) % 4];
+        int n = std::max(10, (int)cv::norm(p2 - p1));
+        for (int s = 0; s < n; s++) {
+            float t = (float)s / n;
+            int x = (int)(p1.x + t * (p2.x - p1.x));
+            int y = (int)(p1.y + t * (p2.y - p1.y));
+            if (x >= 0 && x < mag.cols && y >= 0 && y < mag.rows) {
+                total += mag.at<float>(y, x);
+                samples++;
+            }
+        }
+    }
+    return samples > 0 ? total / samples : 0;
+}
+
+// S plane of the 8-bit BGR2HSV conversion.
+inline cv::Mat refSaturation(const cv::Mat& bgr) {
+    cv::Mat hsv, sat;
+    cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
+    cv::extractChannel(hsv, sat, 1);
+    return sat;
+}
+
+// Otsu level as cv::threshold picks it.
+inline int refOtsu(const cv::Mat& gray) {
+    cv::Mat unused;
+    return (int)cv::threshold(gray, unused, 0, 255,
+                              cv::THRESH_BINARY | cv::THRESH_OTSU);
+}
+
+// L, a, b planes of the 8-bit BGR2Lab conversion.
+inline std::vector<cv::Mat> refLab(const cv::Mat& bgr) {
+    cv::Mat lab;
+    cv::cvtColor(bgr, lab, cv::COLOR_BGR2Lab);
+    std::vector<cv::Mat> planes;
+    cv::split(lab, planes);
+    return planes;
+}
+
+// Delta E (CIE76, float Lab) from the mean border colour (every other
+// border pixel), min-max stretched to 8 bits.
+inline cv::Mat refColorDistance(const cv::Mat& bgr) {
+    cv::Mat f, lab;
+    bgr.convertTo(f, CV_32F, 1.0 / 255);
+    cv::cvtColor(f, lab, cv::COLOR_BGR2Lab);
+    int h = lab.rows, w = lab.cols;
+    double sum[3] = {0, 0, 0};
+    int n = 0;
+    auto add = [&](int y, int x) {
+        const cv::Vec3f& p = lab.at<cv::Vec3f>(y, x);
+        for (int c = 0; c < 3; c++) sum[c] += p[c];
+        n++;
+    };
+    for (int x = 0; x < w; x += 2) { add(0, x); add(h - 1, x); }
+    for (int y = 1; y < h - 1; y += 2) { add(y, 0); add(y, w - 1); }
+
+    cv::Mat dist(h, w, CV_32FC1), out;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            const cv::Vec3f& p = lab.at<cv::Vec3f>(y, x);
+            double d2 = 0;
+            for (int c = 0; c < 3; c++) {
+                double d = p[c] - sum[c] / n;
+                d2 += d * d;
+            }
+            dist.at<float>(y, x) = (float)std::sqrt(d2);
+        }
+    }
+    cv::normalize(dist, out, 0, 255, cv::NORM_MINMAX);
+    out.convertTo(out, CV_8UC1);
+    return out;
+}
+
+// 0/255 mask of `gray >= level`.
+inline cv::Mat refThreshold(const cv::Mat& gray, int level) {
+    cv::Mat mask;
+    cv::compare(gray, level, mask, cv::CMP_GE);
+    return mask;
+}
+
+// Rectangular morphology with OpenCV's default border handling.
+inline cv::Mat refMorphology(const cv::Mat& mask, int op, int kw, int kh,
+                             int iterations) {
+    cv::Mat out;
+    cv::morphologyEx(mask, out, op,
+                     cv::getStructuringElement(cv::MORPH_RECT,
+                                               cv::Size(kw, kh)),
+                     cv::Point(-1, -1), iterations);
+    return out;
+}
+
+// Outer contours, CHAIN_APPROX_SIMPLE.  The one-pixel frame is cleared
+// first: OpenCV versions differ on whether findContours() sees it.
+inline std::vector<std::vector<cv::Point>> refOuterContours(const cv::Mat& mask) {
+    cv::Mat m = mask.clone();
+    cv::rectangle(m, cv::Rect(0, 0, m.cols, m.rows), cv::Scalar(0));
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(m, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    return contours;
+}
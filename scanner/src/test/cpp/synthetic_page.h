@@ -0,0 +1,167 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ===================================================================
+// Synthetic camera frames with a known page, shared by the host tools.
+// ===================================================================
+
+struct SyntheticPage {
+    cv::Mat bgr;                      // working resolution
+    std::vector<cv::Point> corners;   // clockwise, may leave the frame
+};
+
+// Desk, page, text and lighting all random, within what a camera
+// frame at working resolution looks like.  Frame `i` of `seed` is the
+// same on every run.
+inline SyntheticPage syntheticPage(uint64_t seed, int i, int maxSide) {
+    cv::RNG rng(seed * 1000003u + i);
+    int w = rng.uniform(320, maxSide + 1), h = rng.uniform(240, maxSide + 1);
+    cv::Mat bgr(h, w, CV_8UC3);
+    cv::Scalar desk(rng.uniform(20, 200), rng.uniform(20, 200),
+                    rng.uniform(20, 200));
+    cv::randn(bgr, desk, cv::Scalar::all(rng.uniform(2, 20)));
+
+    cv::Point2f c(w * rng.uniform(0.4f, 0.6f), h * rng.uniform(0.4f, 0.6f));
+    cv::RotatedRect rect(c, cv::Size2f(w * rng.uniform(0.3f, 0.85f),
+                                       h * rng.uniform(0.3f, 0.85f)),
+                         rng.uniform(-30.f, 30.f));
+    cv::Point2f v[4];
+    rect.points(v);
+    std::vector<cv::Point> page;
+    for (auto& p : v) {
+        p += cv::Point2f(rng.uniform(-0.04f, 0.04f) * w,
+                         rng.uniform(-0.04f, 0.04f) * h);
+        page.push_back(p);
+    }
+    int paper = rng.uniform(150, 256);
+    cv::fillConvexPoly(bgr, page,
+                       cv::Scalar(paper - rng.uniform(0, 30),
+                                  paper - rng.uniform(0, 30), paper),
+                       cv::LINE_AA);
+    int lines = rng.uniform(0, 20);
+    for (int l = 1; l <= lines; l++) {
+        float t = (float)l / (lines + 1);
+        cv::Point2f a = v[1] + (v[0] - v[1]) * t, b = v[2] + (v[3] - v[2]) * t;
+        cv::line(bgr, a + (b - a) * 0.1f, a + (b - a) * rng.uniform(0.5f, 0.9f),
+                 cv::Scalar::all(rng.uniform(0, 90)), 1, cv::LINE_AA);
+    }
+    if (rng.uniform(0, 2)) {
+        // Soft shadow across part of the frame
+        cv::Mat shade(h, w, CV_8UC3, cv::Scalar::all(0));
+        cv::circle(shade, cv::Point(rng.uniform(0, w), rng.uniform(0, h)),
+                   rng.uniform(w / 4, w), cv::Scalar::all(rng.uniform(20, 80)),
+                   -1);
+        cv::GaussianBlur(shade, shade, cv::Size(0, 0), w / 16.0);
+        bgr -= shade;
+    }
+    if (rng.uniform(0, 2)) cv::GaussianBlur(bgr, bgr, cv::Size(3, 3), 0);
+
+    return {bgr, page};
+}
+
+struct SyntheticTextPage {
+    cv::Mat bgr;                      // working resolution
+    std::vector<cv::Point> corners;   // TL TR BR BL as captured
+    int degrees;                      // clockwise turn that makes it upright
+};
+
+// A printed A4 page of left-aligned text lines, captured turned
+// clockwise by `rotation` (0, 90, 180 or 270) under a mild perspective.
+// Frame `i` of `seed` is the same on every run.
+inline SyntheticTextPage syntheticTextPage(uint64_t seed, int i, int maxSide,
+                                           int rotation) {
+    cv::RNG rng(seed * 1000003u + i * 4 + rotation / 90);
+    const int W = 1240, H = 1754;
+    cv::Mat page(H, W, CV_8UC1, cv::Scalar::all(rng.uniform(190, 256)));
+    int lines = rng.uniform(12, 51);
+    double lh = H * 0.9 / lines;
+    double scale = lh / 40.0 * rng.uniform(0.8, 1.1);
+    int thickness = std::max(1, (int)(scale * 2));
+    int margin = (int)(W * rng.uniform(0.06, 0.12));
+    cv::Scalar ink = cv::Scalar::all(rng.uniform(0, 80));
+    double y = H * 0.06 + lh;
+    for (int l = 0; l < lines; l++, y += lh) {
+        int x = margin + (rng.uniform(0.0, 1.0) < 0.15 ? (int)(W * 0.04) : 0);
+        // Mostly full lines, some ending a paragraph early
+        double target = (W - 2 * margin) * (rng.uniform(0.0, 1.0) < 0.25
+                                                ? rng.uniform(0.3, 1.0)
+                                                : rng.uniform(0.85, 1.0));
+        std::string text;
+        for (;;) {
+            std::string word;
+            int letters = rng.uniform(1, 10);
+            for (int k = 0; k < letters; k++) word += (char)('a' + rng.uniform(0, 26));
+            if (rng.uniform(0.0, 1.0) < 0.1) word[0] = (char)(word[0] - 'a' + 'A');
+            std::string longer = text.empty() ? word : text + " " + word;
+            int baseline;
+            if (cv::getTextSize(longer, cv::FONT_HERSHEY_SIMPLEX, scale,
+                                thickness, &baseline).width > target)
+                break;
+            text = longer;
+        }
+        cv::putText(page, text, cv::Point(x, (int)y), cv::FONT_HERSHEY_SIMPLEX,
+                    scale, ink, thickness, cv::LINE_AA);
+    }
+    if (rotation == 90) cv::rotate(page, page, cv::ROTATE_90_CLOCKWISE);
+    else if (rotation == 180) cv::rotate(page, page, cv::ROTATE_180);
+    else if (rotation == 270) cv::rotate(page, page, cv::ROTATE_90_COUNTERCLOCKWISE);
+
+    int w = rng.uniform(420, maxSide + 1), h = rng.uniform(320, maxSide + 1);
+    cv::Mat desk(h, w, CV_8UC1);
+    cv::randn(desk, cv::Scalar::all(rng.uniform(20, 200)),
+              cv::Scalar::all(rng.uniform(2, 20)));
+    double s = std::min(w * rng.uniform(0.55, 0.9) / page.cols,
+                        h * rng.uniform(0.55, 0.9) / page.rows);
+    cv::Mat small;
+    cv::resize(page, small, cv::Size(std::max(1, (int)(page.cols * s)),
+                                     std::max(1, (int)(page.rows * s))),
+               0, 0, cv::INTER_AREA);
+
+    cv::Point2f c(w * (0.5f + rng.uniform(-0.05f, 0.05f)),
+                  h * (0.5f + rng.uniform(-0.05f, 0.05f)));
+    float a = rng.uniform(-15.f, 15.f) * (float)CV_PI / 180;
+    float sw = (float)small.cols, sh = (float)small.rows;
+    cv::Point2f src[4] = {{0, 0}, {sw, 0}, {sw, sh}, {0, sh}}, dst[4];
+    std::vector<cv::Point> corners;
+    for (int k = 0; k < 4; k++) {
+        cv::Point2f p = src[k] - cv::Point2f(sw / 2, sh / 2);
+        dst[k] = c + cv::Point2f(p.x * std::cos(a) - p.y * std::sin(a),
+                                 p.x * std::sin(a) + p.y * std::cos(a)) +
+                 cv::Point2f(rng.uniform(-0.04f, 0.04f) * w,
+                             rng.uniform(-0.04f, 0.04f) * h);
+        corners.push_back(dst[k]);
+    }
+    cv::warpPerspective(small, desk, cv::getPerspectiveTransform(src, dst),
+                        desk.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+    if (rng.uniform(0, 2)) cv::GaussianBlur(desk, desk, cv::Size(3, 3), 0);
+
+    cv::Mat bgr;
+    cv::cvtColor(desk, bgr, cv::COLOR_GRAY2BGR);
+    return {bgr, corners, (360 - rotation) % 360};
+}
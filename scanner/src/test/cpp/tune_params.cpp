@@ -0,0 +1,376 @@
+/*
+ * TrudidoScannerSDK
+ * Copyright (C) 2026 Dominik
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Offline search over DetectorParams.  Every profile runs
+// detectDocument() on the same corpus - synthetic pages with known
+// corners, plus optionally photos with labelled corners - and is scored
+// on recall, corner error and capture time per frame.  Profiles whose
+// 95th-percentile frame time is over the budget are discarded; the
+// Pareto front of the rest is printed, fastest first:
+//
+//   tune_params --random 300 --trials 200 --budget 40 --out front.txt
+//   tune_params --corpus 'photos/*.jpg' --labels photos.txt ...
+//
+// The first profile is always the defaults.  The first half of the
+// trials sample the space uniformly, the rest perturb a random member
+// of the front found so far.
+//
+// Labels use kernel_diff's --record format (corners in the working
+// frame), so a recorded file can be corrected by hand and reused.  A
+// page is found when every corner lies within --tolerance px of its
+// label; the corner error is that worst-corner distance, averaged over
+// the pages found.  Synthetic pages that leave the frame, and photos
+// without a label, only count toward the frame time.
+
+#include "detector.h"
+#include "ingest.h"
+#include "synthetic_page.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Case {
+    std::string name;
+    cv::Mat bgr;                    // working resolution
+    std::vector<cv::Point> page;    // empty when there is no whole page
+};
+
+struct Score {
+    double recall = 0;
+    double error = 0;     // px, worst corner, mean over found pages
+    double meanMs = 0;
+    double p95Ms = 0;
+};
+
+struct Profile {
+    DetectorParams params;
+    Score score;
+};
+
+// --- search space -------------------------------------------------
+
+// One tunable value.  `step` quantises it (0: continuous); a skippable
+// one is a pass that may also be switched off (0).
+struct Dimension {
+    const char* name;
+    double lo, hi, step;
+    bool skippable;
+    double (*get)(const DetectorParams&);
+    void (*set)(DetectorParams&, double);
+};
+
+#define DIM(field, lo, hi, step, skip)                                   \
+    {#field, lo, hi, step, skip,                                         \
+     [](const DetectorParams& p) { return (double)p.field; },            \
+     [](DetectorParams& p, double v) { p.field = (decltype(+p.field))v; }}
+
+const Dimension DIMENSIONS[] = {
+    DIM(minArea, 0.02, 0.10, 0, false),
+    DIM(maxArea, 0.70, 0.95, 0, false),
+    DIM(maxCornerCos, 0.2, 0.6, 0, false),
+    DIM(borderMargin, 2, 10, 1, false),
+    DIM(contourLimit, 4, 40, 1, false),
+    DIM(approxEps[0], 0.01, 0.03, 0, false),
+    DIM(approxEps[1], 0.03, 0.07, 0, true),
+    DIM(cannyScale, 0.6, 1.6, 0, false),
+    DIM(gradientKernels[0], 2, 4, 1, false),
+    DIM(gradientKernels[1], 2, 5, 1, true),
+    DIM(claheClip, 1.5, 5.0, 0, false),
+};
+
+#undef DIM
+
+double quantise(const Dimension& d, double v) {
+    v = std::min(std::max(v, d.lo), d.hi);
+    if (d.step > 0) v = d.lo + std::round((v - d.lo) / d.step) * d.step;
+    return v;
+}
+
+DetectorParams sampleParams(cv::RNG& rng) {
+    DetectorParams p;
+    for (const Dimension& d : DIMENSIONS) {
+        bool off = d.skippable && rng.uniform(0, 4) == 0;
+        d.set(p, off ? 0 : quantise(d, rng.uniform(d.lo, d.hi)));
+    }
+    return p;
+}
+
+// A few values of `base` moved by a fraction of their range
+DetectorParams perturb(const DetectorParams& base, cv::RNG& rng) {
+    DetectorParams p = base;
+    const int n = sizeof(DIMENSIONS) / sizeof(DIMENSIONS[0]);
+    int moved = 0;
+    while (moved == 0) {
+        for (const Dimension& d : DIMENSIONS) {
+            if (rng.uniform(0, n) >= 3) continue;
+            double v = d.get(p);
+            if (d.skippable && (v == 0 || rng.uniform(0, 8) == 0))
+                v = v == 0 ? rng.uniform(d.lo, d.hi) : 0;
+            else
+                v += rng.gaussian(0.15 * (d.hi - d.lo));
+            d.set(p, v == 0 ? 0 : quantise(d, v));
+            moved++;
+        }
+    }
+    return p;
+}
+
+std::string paramsToString(const DetectorParams& p) {
+    std::ostringstream s;
+    for (const Dimension& d : DIMENSIONS)
+        s << (&d == DIMENSIONS ? "" : " ") << d.name << '=' << d.get(p);
+    return s.str();
+}
+
+// --- inputs -------------------------------------------------------
+
+bool insideFrame(const std::vector<cv::Point>& quad, const cv::Mat& img) {
+    cv::Rect frame(0, 0, img.cols, img.rows);
+    for (const auto& p : quad)
+        if (!frame.contains(p)) return false;
+    return true;
+}
+
+std::vector<Case> syntheticCases(uint64_t seed, int count) {
+    std::vector<Case> cases;
+    for (int i = 0; i < count; i++) {
+        SyntheticPage s = syntheticPage(seed, i, TARGET);
+        Case k;
+        k.name = "random-" + std::to_string(seed) + "-" + std::to_string(i);
+        k.bgr = s.bgr;
+        if (insideFrame(s.corners, s.bgr)) k.page = s.corners;
+        cases.push_back(k);
+    }
+    return cases;
+}
+
+// name TAB count x y x y ..., as kernel_diff --record writes it
+std::map<std::string, std::vector<cv::Point>> readLabels(const std::string& path) {
+    std::map<std::string, std::vector<cv::Point>> labels;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        size_t n = 0;
+        if (!std::getline(fields, name, '\t') || !(fields >> n) || n != 4)
+            continue;
+        std::vector<cv::Point> q(n);
+        for (auto& p : q) fields >> p.x >> p.y;
+        if (fields) labels[name] = q;
+    }
+    return labels;
+}
+
+std::vector<Case> corpusCases(const std::string& glob,
+                              const std::map<std::string,
+                                             std::vector<cv::Point>>& labels) {
+    std::vector<cv::String> files;
+    cv::glob(glob, files, false);
+    std::vector<Case> cases;
+    for (const auto& f : files) {
+        cv::Mat img = cv::imread(f, cv::IMREAD_COLOR);
+        if (img.empty()) continue;
+        Case k;
+        k.name = f;
+        double scale;
+        k.bgr = ingestFrame(img, TARGET, scale);
+        auto l = labels.find(f);
+        if (l != labels.end()) k.page = l->second;
+        cases.push_back(k);
+    }
+    return cases;
+}
+
+// --- evaluation ---------------------------------------------------
+
+// Worst corner distance for the best cyclic alignment of the corners
+double cornerError(const std::vector<cv::Point>& quad,
+                   const std::vector<cv::Point>& label) {
+    if (quad.size() != 4) return INFINITY;
+    double best = INFINITY;
+    for (int shift = 0; shift < 4; shift++) {
+        double worst = 0;
+        for (int i = 0; i < 4; i++)
+            worst = std::max(worst, cv::norm(quad[(i + shift) % 4] - label[i]));
+        best = std::min(best, worst);
+    }
+    return best;
+}
+
+Score evaluate(const DetectorParams& params, const std::vector<Case>& cases,
+               double tolerance) {
+    setDetectorParams(params);
+    Score score;
+    std::vector<double> ms;
+    ms.reserve(cases.size());
+    int labelled = 0, found = 0;
+    for (const Case& c : cases) {
+        int64 t0 = cv::getTickCount();
+        std::vector<cv::Point> quad = detectDocument(c.bgr, 1.0, false);
+        ms.push_back((cv::getTickCount() - t0) * 1000.0 / cv::getTickFrequency());
+        if (c.page.empty()) continue;
+        labelled++;
+        double e = cornerError(quad, c.page);
+        if (e <= tolerance) {
+            found++;
+            score.error += e;
+        }
+    }
+    if (labelled) score.recall = (double)found / labelled;
+    if (found) score.error /= found;
+    if (!ms.empty()) {
+        for (double t : ms) score.meanMs += t;
+        score.meanMs /= ms.size();
+        size_t k = std::min(ms.size() - 1, ms.size() * 95 / 100);
+        std::nth_element(ms.begin(), ms.begin() + k, ms.end());
+        score.p95Ms = ms[k];
+    }
+    return score;
+}
+
+bool dominates(const Score& a, const Score& b) {
+    if (a.recall < b.recall || a.error > b.error || a.p95Ms > b.p95Ms)
+        return false;
+    return a.recall > b.recall || a.error < b.error || a.p95Ms < b.p95Ms;
+}
+
+// Adds `p` unless something on the front dominates it; drops what it
+// dominates.  True when it was added.
+bool updateFront(std::vector<Profile>& front, const Profile& p) {
+    for (const Profile& q : front)
+        if (dominates(q.score, p.score)) return false;
+    front.erase(std::remove_if(front.begin(), front.end(),
+                               [&](const Profile& q) {
+                                   return dominates(p.score, q.score);
+                               }),
+                front.end());
+    front.push_back(p);
+    return true;
+}
+
+void printScore(const char* label, const Score& s) {
+    std::printf("%-8s recall %.3f  error %5.2f px  mean %6.1f ms  p95 %6.1f ms\n",
+                label, s.recall, s.error, s.meanMs, s.p95Ms);
+}
+
+void usage() {
+    std::fprintf(stderr,
+        "usage: tune_params [--random N] [--seed S] [--corpus GLOB]\n"
+        "                   [--labels FILE] [--trials N] [--budget MS]\n"
+        "                   [--tolerance PX] [--out FILE]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int randomCount = 200, trials = 100;
+    uint64_t seed = 1;
+    double budgetMs = 0, tolerance = 8;
+    std::string corpus, labelsPath, outPath;
+    for (int i = 1; i < argc; i++) {
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) { usage(); std::exit(2); }
+            return argv[++i];
+        };
+        if (!std::strcmp(argv[i], "--random")) randomCount = std::atoi(next());
+        else if (!std::strcmp(argv[i], "--seed")) seed = std::strtoull(next(), nullptr, 10);
+        else if (!std::strcmp(argv[i], "--corpus")) corpus = next();
+        else if (!std::strcmp(argv[i], "--labels")) labelsPath = next();
+        else if (!std::strcmp(argv[i], "--trials")) trials = std::atoi(next());
+        else if (!std::strcmp(argv[i], "--budget")) budgetMs = std::atof(next());
+        else if (!std::strcmp(argv[i], "--tolerance")) tolerance = std::atof(next());
+        else if (!std::strcmp(argv[i], "--out")) outPath = next();
+        else { usage(); return 2; }
+    }
+
+    std::vector<Case> cases = syntheticCases(seed, randomCount);
+    if (!corpus.empty()) {
+        auto more = corpusCases(corpus, readLabels(labelsPath));
+        cases.insert(cases.end(), more.begin(), more.end());
+    }
+    if (cases.empty()) {
+        std::fprintf(stderr, "empty corpus\n");
+        return 2;
+    }
+    int labelled = 0;
+    for (const Case& c : cases) labelled += !c.page.empty();
+    std::printf("%d frames, %d with a labelled page\n",
+                (int)cases.size(), labelled);
+
+    // Lazily built kernels and tables must not land in the first profile
+    detectDocument(cases[0].bgr, 1.0, false);
+
+    auto fits = [&](const Score& s) {
+        return budgetMs <= 0 || s.p95Ms <= budgetMs;
+    };
+    std::vector<Profile> front;
+    cv::RNG rng(seed);
+    Profile defaults{DetectorParams(), {}};
+    defaults.score = evaluate(defaults.params, cases, tolerance);
+    printScore("default", defaults.score);
+    if (fits(defaults.score)) updateFront(front, defaults);
+
+    for (int t = 1; t < trials; t++) {
+        Profile p;
+        p.params = t < trials / 2 || front.empty()
+                 ? sampleParams(rng)
+                 : perturb(front[rng.uniform(0, (int)front.size())].params, rng);
+        p.score = evaluate(p.params, cases, tolerance);
+        if (fits(p.score) && updateFront(front, p)) {
+            char label[16];
+            std::snprintf(label, sizeof(label), "#%d", t);
+            printScore(label, p.score);
+        }
+    }
+    setDetectorParams(DetectorParams());
+
+    if (front.empty()) {
+        std::printf("no profile fits a p95 of %g ms\n", budgetMs);
+        return 1;
+    }
+    std::sort(front.begin(), front.end(), [](const Profile& a, const Profile& b) {
+        return a.score.p95Ms < b.score.p95Ms;
+    });
+
+    std::ofstream out;
+    if (!outPath.empty()) out.open(outPath);
+    std::printf("\nPareto front (%d profiles):\n", (int)front.size());
+    for (const Profile& p : front) {
+        const Score& s = p.score;
+        printScore("", s);
+        std::printf("         %s\n", paramsToString(p.params).c_str());
+        if (out.is_open())
+            out << "# recall " << s.recall << " error " << s.error
+                << " mean " << s.meanMs << " p95 " << s.p95Ms << '\n'
+                << paramsToString(p.params) << '\n';
+    }
+    return 0;
+}